@@ -0,0 +1,102 @@
+/*
+ *  AtomicWriter.h
+ *  OksSystem
+ *
+ *  Atomic and durable replacement of the content of a file.
+ *
+ */
+
+#ifndef OKSSYSTEM_ATOMIC_WRITER
+#define OKSSYSTEM_ATOMIC_WRITER
+
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+
+#include <stddef.h>
+#include <sys/types.h>
+
+namespace OksSystem {
+
+    class File ;
+
+    /** This class replaces the content of a file atomically: readers see either the old or the new content,
+      * never a partially written file, and after a crash the file holds one of them.
+      * The data is written to an anonymous file (\c O_TMPFILE) in the directory of the target,
+      * or to a hidden temporary file (\c mkostemp) on file systems without \c O_TMPFILE.
+      * \c commit() flushes the data (\c fdatasync), links the file in the directory (\c linkat),
+      * renames it over the target and flushes the directory, so that the rename itself is durable.
+      * When many files are written, the flush of the directories can be done once for all of them
+      * by passing a \c SyncBatch to the writers.
+      * If the writer is destroyed without \c commit(), the target is left untouched.
+      * Unless explicit permissions are given, the new file keeps the permissions of the target,
+      * or gets the default permissions of a new file (\c 0666 masked by the umask) if the target does not exist.
+      * \code
+      * OksSystem::AtomicWriter writer = OksSystem::File("run.state").atomic_writer();
+      * writer.write(state.data(),state.size());
+      * writer.commit();
+      * \endcode
+      * \brief Atomic file replacement
+      * \see OksSystem::File::atomic_write()
+      * \see OksSystem::File::atomic_writer()
+      */
+
+    class AtomicWriter {
+public:
+	/** Set of directories whose flush (\c fsync) is deferred.
+	  * Writers committed with a batch only register their directory,
+	  * each directory is flushed once by \c sync() or by the destructor.
+	  * The batch can be shared by writers in several threads.
+	  * \brief Batch of directory flushes
+	  */
+	class SyncBatch {
+	protected:
+	    std::mutex m_mutex ;                                      ///< \brief protects the directories */
+	    std::set<std::string> m_directories ;                     ///< \brief directories to flush */
+	private:
+	    SyncBatch(const SyncBatch &) ;                            ///< \brief not copyable */
+	    SyncBatch & operator=(const SyncBatch &) ;                ///< \brief not assignable */
+	public:
+	    SyncBatch() ;
+	    ~SyncBatch() ;
+	    void add(const std::string &directory) ;                  ///< \brief registers a directory to flush */
+	    size_t size() ;                                           ///< \brief number of directories to flush */
+	    void sync() ;                                             ///< \brief flushes the directories */
+	} ; // SyncBatch
+
+	static const mode_t KEEP_PERMISSIONS = (mode_t) -1 ;          ///< \brief keep the permissions of the target */
+	static void sync_directory(const std::string &directory) ;    ///< \brief flushes a directory */
+protected:
+	std::string m_target ;                                        ///< \brief path of the file to replace */
+	std::string m_directory ;                                     ///< \brief directory of the target */
+	std::string m_temporary ;                                     ///< \brief name of the temporary file, empty for an anonymous file */
+	SyncBatch *m_batch ;                                          ///< \brief batch for the directory flush, can be null */
+	size_t m_size ;                                               ///< \brief bytes written */
+	int m_fd ;                                                    ///< \brief descriptor of the temporary file */
+	mode_t target_permissions() const ;                           ///< \brief permissions the target has or would get */
+	void open(mode_t permissions) ;                               ///< \brief creates the temporary file */
+	int link(const std::string &name) throw() ;                   ///< \brief gives a name to the anonymous file */
+	void discard() throw() ;                                      ///< \brief closes and removes the temporary file */
+private:
+	AtomicWriter(const AtomicWriter &) ;                          ///< \brief not copyable */
+	AtomicWriter & operator=(const AtomicWriter &) ;              ///< \brief not assignable */
+public:
+	AtomicWriter(const File &target, mode_t permissions = KEEP_PERMISSIONS, SyncBatch *batch = 0) ;
+	AtomicWriter(AtomicWriter &&other) throw() ;
+	~AtomicWriter() ;
+
+	void write(const void *data, size_t size) ;                   ///< \brief appends data to the new content */
+	void write(std::string_view data) ;                           ///< \brief appends data to the new content */
+	void commit() ;                                               ///< \brief replaces the target with the new content */
+	void abort() throw() ;                                        ///< \brief drops the new content */
+	bool is_open() const throw() { return m_fd>=0 ; }             ///< \brief is the writer neither committed nor aborted */
+	bool is_anonymous() const throw() { return m_temporary.empty() ; } ///< \brief is the new content in an \c O_TMPFILE file */
+	size_t size() const throw() { return m_size ; }               ///< \brief bytes written so far */
+	int fd() const throw() { return m_fd ; }                      ///< \brief descriptor of the new content */
+	const std::string & target() const throw() { return m_target ; } ///< \brief path of the file to replace */
+    } ; // AtomicWriter
+
+} // OksSystem
+
+#endif
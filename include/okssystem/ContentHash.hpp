@@ -0,0 +1,71 @@
+/*
+ *  ContentHash.h
+ *  OksSystem
+ *
+ *  Hashing of the content of files, in parallel.
+ *
+ */
+
+#ifndef OKSSYSTEM_CONTENT_HASH
+#define OKSSYSTEM_CONTENT_HASH
+
+#include <string>
+#include <vector>
+
+#include <stddef.h>
+
+namespace OksSystem {
+
+    class File ;
+
+    /** This class computes digests of the content of files, without external processes.
+      * Three algorithms are available, all implemented in the package: XXH128 (XXH3 128 bits), 
+      * the fastest, a non cryptographic hash for change detection, XXH64 for compatibility with existing \c xxhsum digests,
+      * and SHA-256 for integrity checks.
+      * Each exists in two variants:
+      * \li the plain variant hashes the file sequentially, its digest is the usual one (as given by \c sha256sum, \c xxh128sum or \c xxhsum);
+      * \li the tree variant splits the content in chunks of \c CHUNK_SIZE bytes, hashed in parallel for regular files,
+      *     the digest is the hash of the digests of the chunks followed by the size of the content (64 bits, little endian).
+      *     It is much faster for large files, but only comparable with other tree digests. It does not depend on
+      *     how the content is read: a pipe or a block of memory gives the same digest as a file with the same bytes.
+      * Files are read with \c pread into large page aligned buffers, each chunk by its own worker.
+      * \c hash_many() hashes many files at once, sharing the workers between the files and their chunks.
+      * Digests are given as lower case hexadecimal strings.
+      * \brief File content digests
+      * \see OksSystem::File::hash(ContentHash::algorithm_t,unsigned int)
+      */
+
+    class ContentHash {
+public:
+	/** Hash algorithms */
+	enum algorithm_t {
+	    XXH64,                                                    ///< \brief 64 bits xxHash, sequential */
+	    XXH64_TREE,                                               ///< \brief 64 bits xxHash, chunks hashed in parallel */
+	    SHA256,                                                   ///< \brief SHA-256, sequential */
+	    SHA256_TREE,                                              ///< \brief SHA-256, chunks hashed in parallel */
+	    XXH128,                                                   ///< \brief 128 bits XXH3, sequential */
+	    XXH128_TREE                                               ///< \brief 128 bits XXH3, chunks hashed in parallel */
+	} ;
+
+	/** Result of the hashing of one file in \c hash_many() */
+	struct Result {
+	    std::string digest ;                                      ///< \brief the digest, empty on error */
+	    int error ;                                               ///< \brief 0 on success, else the \c errno value */
+	    Result() throw() : error(0) {}
+	} ; // Result
+	typedef std::vector<Result> result_list_t ;
+
+	static const size_t CHUNK_SIZE ;                              ///< \brief size of the chunks of the tree variants */
+	static const size_t BUFFER_SIZE ;                             ///< \brief size of the read buffers */
+
+	static const char *name(algorithm_t algorithm) throw() ;      ///< \brief name of an algorithm */
+	static bool is_tree(algorithm_t algorithm) throw() ;          ///< \brief is the algorithm a tree variant */
+	static std::string hash(const void *data, size_t size, algorithm_t algorithm) ; ///< \brief digest of a block of memory */
+	static std::string hash(const File &file, algorithm_t algorithm, unsigned int workers = 0) ; ///< \brief digest of a file */
+	static result_list_t hash_many(const File *files, size_t count, algorithm_t algorithm, unsigned int workers = 0) ; ///< \brief digests of many files */
+	static result_list_t hash_many(const std::vector<File> &files, algorithm_t algorithm, unsigned int workers = 0) ; ///< \brief digests of many files */
+    } ; // ContentHash
+
+} // OksSystem
+
+#endif
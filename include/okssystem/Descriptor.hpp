@@ -31,6 +31,7 @@ namespace OksSystem {
   public:
 
     Descriptor(const File * file, int flags, mode_t perm );     
+    Descriptor(int fd, const std::string &name );               /**< \brief takes ownership of an open descriptor */
     ~Descriptor();  
     
     static int flags(bool read_mode, bool write_mode); 
@@ -44,6 +45,7 @@ namespace OksSystem {
     int write(const void * buffer, size_t number) const;  
 
     int fd() const throw();					/**< \brief file descritptor */    
+    const std::string & name() const throw();			/**< \brief name of the file */
     
     void closeOnExec();
 
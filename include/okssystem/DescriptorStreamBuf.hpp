@@ -0,0 +1,114 @@
+/*
+ *  DescriptorStreamBuf.h
+ *  OksSystem
+ *
+ *  Stream buffer reading from or writing to a file descriptor.
+ *
+ */
+
+#ifndef OKSSYSTEM_DESCRIPTOR_STREAMBUF
+#define OKSSYSTEM_DESCRIPTOR_STREAMBUF
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "okssystem/Descriptor.hpp"
+
+namespace OksSystem {
+
+    class File ;
+
+    /** This class is a stream buffer working directly on a file descriptor (an OksSystem::Descriptor).
+      * Compared to \c std::filebuf, the size of the buffer can be chosen (large buffers make streams
+      * writing many small chunks much cheaper, as each \c overflow is a system call),
+      * the buffer can be backed by huge pages, the file is opened with \c O_CLOEXEC and \c O_NOATIME if wanted,
+      * and the descriptor is accessible.
+      * Writes of at least the size of the buffer bypass the buffer.
+      * A failing system call throws an ers issue, which makes the stream bad, the error code is kept in \c error().
+      * \brief Stream buffer on a file descriptor
+      * \see OksSystem::File::input(const DescriptorStreamBuf::Options &)
+      * \see OksSystem::File::output(bool, const DescriptorStreamBuf::Options &)
+      */
+
+    class DescriptorStreamBuf : public std::streambuf {
+public:
+	static const size_t DEFAULT_BUFFER_SIZE ;                     ///< \brief default size of the buffer */
+	static const size_t HUGE_PAGE_SIZE ;                          ///< \brief size of a huge page */
+
+	/** Options for opening the file and for the buffer */
+	struct Options {
+	    size_t buffer_size ;                                      ///< \brief size of the buffer */
+	    bool close_on_exec ;                                      ///< \brief open with \c O_CLOEXEC */
+	    bool no_atime ;                                           ///< \brief open with \c O_NOATIME (input only, ignored if not permitted) */
+	    bool huge_pages ;                                         ///< \brief back the buffer with huge pages, if possible */
+	    explicit Options(size_t size = DEFAULT_BUFFER_SIZE) throw() ;
+	} ; // Options
+
+	static int open(const File &file, int flags, mode_t permissions, const Options &options) ; ///< \brief opens a file with the options */
+protected:
+	std::unique_ptr<Descriptor> m_descriptor ;                    ///< \brief the descriptor */
+	char *m_buffer ;                                              ///< \brief the buffer */
+	size_t m_buffer_size ;                                        ///< \brief size of the buffer */
+	bool m_mapped ;                                               ///< \brief is the buffer mapped (huge pages) */
+	bool m_output ;                                               ///< \brief is the buffer used for output */
+	int m_error ;                                                 ///< \brief error code of the last failure, 0 if none */
+	void allocate(const Options &options) ;                       ///< \brief allocates the buffer */
+	void flush() ;                                                ///< \brief writes the content of the buffer */
+	void write_all(const char *data, size_t size) ;               ///< \brief writes data to the descriptor */
+
+	virtual int_type underflow() ;
+	virtual int_type overflow(int_type c) ;
+	virtual std::streamsize xsputn(const char_type *data, std::streamsize size) ;
+	virtual std::streamsize xsgetn(char_type *data, std::streamsize size) ;
+	virtual int sync() ;
+	virtual pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode) ;
+	virtual pos_type seekpos(pos_type position, std::ios_base::openmode mode) ;
+private:
+	DescriptorStreamBuf(const DescriptorStreamBuf &) ;            ///< \brief not copyable */
+	DescriptorStreamBuf & operator=(const DescriptorStreamBuf &) ; ///< \brief not assignable */
+public:
+	DescriptorStreamBuf(Descriptor *descriptor, bool output, const Options &options = Options()) ;
+	virtual ~DescriptorStreamBuf() ;
+
+	int fd() const throw() ;                                      ///< \brief the file descriptor */
+	size_t buffer_size() const throw() ;                          ///< \brief size of the buffer */
+	bool is_huge() const throw() ;                                ///< \brief is the buffer backed by huge pages */
+	int error() const throw() ;                                   ///< \brief error code of the last failure */
+	void close() ;                                                ///< \brief flushes and closes the descriptor */
+    } ; // DescriptorStreamBuf
+
+    /** Input stream reading from a file descriptor through a DescriptorStreamBuf
+      * \brief Input stream on a file descriptor
+      */
+
+    class DescriptorInputStream : public std::istream {
+protected:
+	DescriptorStreamBuf m_buffer ;                                ///< \brief the stream buffer */
+public:
+	DescriptorInputStream(Descriptor *descriptor, const DescriptorStreamBuf::Options &options = DescriptorStreamBuf::Options()) ;
+	DescriptorStreamBuf *rdbuf() throw() { return &m_buffer ; }   ///< \brief the stream buffer */
+	int fd() const throw() { return m_buffer.fd() ; }             ///< \brief the file descriptor */
+    } ; // DescriptorInputStream
+
+    /** Output stream writing to a file descriptor through a DescriptorStreamBuf
+      * \brief Output stream on a file descriptor
+      */
+
+    class DescriptorOutputStream : public std::ostream {
+protected:
+	DescriptorStreamBuf m_buffer ;                                ///< \brief the stream buffer */
+public:
+	DescriptorOutputStream(Descriptor *descriptor, const DescriptorStreamBuf::Options &options = DescriptorStreamBuf::Options()) ;
+	DescriptorStreamBuf *rdbuf() throw() { return &m_buffer ; }   ///< \brief the stream buffer */
+	int fd() const throw() { return m_buffer.fd() ; }             ///< \brief the file descriptor */
+	void close() ;                                                ///< \brief flushes and closes the descriptor */
+    } ; // DescriptorOutputStream
+
+} // OksSystem
+
+#endif
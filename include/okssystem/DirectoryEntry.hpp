@@ -0,0 +1,73 @@
+/*
+ *  DirectoryEntry.h
+ *  OksSystem
+ *
+ *  Raw entry of a directory listing.
+ *
+ */
+
+#ifndef OKSSYSTEM_DIRECTORY_ENTRY
+#define OKSSYSTEM_DIRECTORY_ENTRY
+
+#include <memory>
+#include <string>
+
+#include <sys/types.h>
+#include <dirent.h>
+
+#include "okssystem/FileId.hpp"
+
+namespace OksSystem {
+
+    class File ;
+
+    /** This class represents an entry of a directory, as returned by the kernel.
+      * It contains the name, the inode number and the type of the entry, no other
+      * system call is needed to obtain them.
+      * Contrary to OksSystem::File the path of the entry is not canonicalized,
+      * this is only done when \c file() is called.
+      * \brief Raw directory entry
+      * \see OksSystem::File::entries()
+      */
+
+    class DirectoryEntry {
+	friend class DirectoryIterator ;
+public:
+	/** Type of the entry, the values match the \c DT_ constants of \c dirent.h */
+	enum type_t {
+	    UNKNOWN   = DT_UNKNOWN,                                   ///< \brief type could not be determined */
+	    FIFO      = DT_FIFO,                                      ///< \brief named pipe */
+	    CHARACTER = DT_CHR,                                       ///< \brief character device */
+	    DIRECTORY = DT_DIR,                                       ///< \brief directory */
+	    BLOCK     = DT_BLK,                                       ///< \brief block device */
+	    REGULAR   = DT_REG,                                       ///< \brief regular file */
+	    SYMLINK   = DT_LNK,                                       ///< \brief symbolic link */
+	    SOCKET    = DT_SOCK                                       ///< \brief unix domain socket */
+	} ;
+	typedef std::shared_ptr<const std::string> path_ptr ;
+protected:
+	path_ptr m_directory ;                                        ///< \brief path of the directory, shared by all entries of a listing */
+	std::string m_name ;                                          ///< \brief name of the entry in the directory */
+	ino_t m_inode ;                                               ///< \brief inode number */
+	dev_t m_device ;                                              ///< \brief device of the directory containing the entry */
+	type_t m_type ;                                               ///< \brief type of the entry */
+public:
+	DirectoryEntry(const path_ptr &directory, const char *name, ino_t inode, unsigned char type, dev_t device = 0) ;
+
+	const std::string & name() const throw() ;                    ///< \brief name of the entry in its directory */
+	const std::string & directory() const throw() ;               ///< \brief path of the directory containing the entry */
+	std::string full_name() const ;                               ///< \brief path of the entry (not canonicalized) */
+	ino_t inode() const throw() ;                                 ///< \brief inode number */
+	FileId id() const throw() ;                                   ///< \brief identity of the entry (device and inode) */
+	type_t type() const throw() ;                                 ///< \brief type of the entry */
+	bool is_regular() const throw() ;                             ///< \brief is the entry a regular file */
+	bool is_directory() const throw() ;                           ///< \brief is the entry a directory */
+	bool is_fifo() const throw() ;                                ///< \brief is the entry a named pipe */
+	bool is_symlink() const throw() ;                             ///< \brief is the entry a symbolic link */
+	OksSystem::File file() const ;                                ///< \brief canonical file for the entry */
+	OksSystem::File link() const ;                                ///< \brief file for the entry, symbolic links not resolved */
+    } ; // DirectoryEntry
+
+} // OksSystem
+
+#endif
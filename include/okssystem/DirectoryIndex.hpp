@@ -0,0 +1,99 @@
+/*
+ *  DirectoryIndex.h
+ *  OksSystem
+ *
+ *  Persistent memory mapped index of a directory tree.
+ *
+ */
+
+#ifndef OKSSYSTEM_DIRECTORY_INDEX
+#define OKSSYSTEM_DIRECTORY_INDEX
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "okssystem/File.hpp"
+#include "okssystem/DirectoryEntry.hpp"
+
+namespace OksSystem {
+
+    class MapFile ;
+
+    /** This class maintains an index of a directory tree in a file, so that applications
+      * discovering the same tree at each start do not have to read all its directories again.
+      * The index contains, for each directory, its entries with their type, size, modification time and inode.
+      * It is written with OksSystem::MapFile and read by mapping it in memory, without any parsing.
+      *
+      * \c update() checks the index against the tree: each directory of the index is checked with a single
+      * \c stat, directories whose modification and change times did not change keep their entries, 
+      * only the others are read again. Since adding, removing or renaming an entry changes the time 
+      * of its directory, this catches all structural changes. A directory whose times were not older than
+      * the previous update by at least \c FileFingerprint::RACY_NS could have changed in the same clock tick
+      * after it was read (its times are then unchanged), so it is read again until it is old enough.
+      * The size and time of files 
+      * whose content changed in place are only refreshed when their directory is read again.
+      * Symbolic links are indexed as such and not followed.
+      * \code
+      * OksSystem::DirectoryIndex index(OksSystem::File("/data/config"),OksSystem::File("/tmp/config.index"));
+      * index.update();
+      * for(size_t i=0;i<index.size();i++) { OksSystem::DirectoryIndex::Entry e = index.entry(i); ... }
+      * \endcode
+      * \brief Memory mapped index of a directory tree
+      */
+
+    class DirectoryIndex {
+public:
+	/** An entry of the index, the strings point into the mapped index */
+	struct Entry {
+	    std::string_view directory ;                              ///< \brief path of the directory containing the entry */
+	    std::string_view name ;                                   ///< \brief name of the entry */
+	    DirectoryEntry::type_t type ;                             ///< \brief type of the entry */
+	    size_t size ;                                             ///< \brief size of the entry */
+	    int64_t modification_ns ;                                 ///< \brief modification time (nanoseconds since the epoch) */
+	    ino_t inode ;                                             ///< \brief inode number */
+	    std::string full_name() const ;                           ///< \brief path of the entry */
+	} ; // Entry
+
+	/** Counters of an update */
+	struct Statistics {
+	    size_t directories_checked ;                              ///< \brief directories of the index checked with stat */
+	    size_t directories_read ;                                 ///< \brief directories read again (new or changed) */
+	    size_t entries_reused ;                                   ///< \brief entries taken from the previous index */
+	    size_t entries_read ;                                     ///< \brief entries read from the file system */
+	    bool written ;                                            ///< \brief was a new index written */
+	    Statistics() throw() ;
+	} ; // Statistics
+
+	static const char MAGIC[8] ;                                  ///< \brief identifies index files */
+	static const uint32_t VERSION ;                               ///< \brief version of the format */
+protected:
+	File m_root ;                                                 ///< \brief root of the indexed tree */
+	File m_index ;                                                ///< \brief index file */
+	std::unique_ptr<MapFile> m_map ;                              ///< \brief the mapped index, null if there is none */
+	const char *m_data ;                                          ///< \brief start of the mapped index */
+	bool load() ;                                                 ///< \brief maps the index file and validates it */
+	void unload() ;                                               ///< \brief unmaps the index file */
+	const void *directory_record(size_t index) const throw() ;    ///< \brief raw directory record */
+	const void *entry_record(size_t index) const throw() ;        ///< \brief raw entry record */
+private:
+	DirectoryIndex(const DirectoryIndex &) ;                      ///< \brief not copyable */
+	DirectoryIndex & operator=(const DirectoryIndex &) ;          ///< \brief not assignable */
+public:
+	DirectoryIndex(const File &root, const File &index) ;
+	~DirectoryIndex() ;
+
+	Statistics update() ;                                         ///< \brief brings the index up to date with the tree */
+	bool is_loaded() const throw() ;                              ///< \brief is an index mapped */
+	size_t size() const throw() ;                                 ///< \brief number of entries */
+	size_t directory_count() const throw() ;                      ///< \brief number of directories */
+	Entry entry(size_t index) const throw() ;                     ///< \brief an entry of the index */
+	const File & root() const throw() ;                           ///< \brief root of the indexed tree */
+	const File & index() const throw() ;                          ///< \brief index file */
+    } ; // DirectoryIndex
+
+} // OksSystem
+
+#endif
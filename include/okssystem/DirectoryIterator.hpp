@@ -0,0 +1,87 @@
+/*
+ *  DirectoryIterator.h
+ *  OksSystem
+ *
+ *  Streaming iteration over the entries of a directory.
+ *
+ */
+
+#ifndef OKSSYSTEM_DIRECTORY_ITERATOR
+#define OKSSYSTEM_DIRECTORY_ITERATOR
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "okssystem/DirectoryEntry.hpp"
+
+namespace OksSystem {
+
+    class File ;
+
+    /** This class iterates over the entries of an open directory.
+      * Entries are read from the kernel in batches into a buffer owned by the iterator,
+      * and handed out one at a time, so that the memory used does not depend on the
+      * size of the directory and the caller can stop at any time.
+      * The entry returned by \c next() (or by dereferencing an iterator) is reused,
+      * it is only valid until the next entry is read.
+      * The class can be used in range based for loops:
+      * \code
+      * OksSystem::DirectoryIterator listing(dir);
+      * for(const OksSystem::DirectoryEntry &entry : listing) { ... }
+      * \endcode
+      * \brief Streaming directory reader
+      * \see OksSystem::File::entries()
+      */
+
+    class DirectoryIterator {
+public:
+	/** Input iterator over the entries of a directory */
+	class iterator {
+	protected:
+	    DirectoryIterator *m_owner ;                          ///< \brief directory being read, null at end */
+	    const DirectoryEntry *m_entry ;                       ///< \brief current entry */
+	public:
+	    typedef std::input_iterator_tag iterator_category ;
+	    typedef DirectoryEntry value_type ;
+	    typedef std::ptrdiff_t difference_type ;
+	    typedef const DirectoryEntry* pointer ;
+	    typedef const DirectoryEntry& reference ;
+	    iterator() throw() ;
+	    iterator(DirectoryIterator *owner) ;
+	    reference operator*() const throw() ;
+	    pointer operator->() const throw() ;
+	    iterator & operator++() ;
+	    bool operator==(const iterator &other) const throw() ;
+	    bool operator!=(const iterator &other) const throw() ;
+	} ; // iterator
+protected:
+	int m_fd ;                                                    ///< \brief descriptor of the open directory */
+	std::vector<char> m_buffer ;                                  ///< \brief buffer for raw kernel entries */
+	long m_count ;                                                ///< \brief number of valid bytes in buffer */
+	long m_position ;                                             ///< \brief position of next entry in buffer */
+	DirectoryEntry m_entry ;                                      ///< \brief current entry (reused) */
+	void open(int parent_fd, const char *name, int flags) ;       ///< \brief opens the directory */
+	bool fill() ;                                                 ///< \brief reads the next batch of entries */
+private:
+	DirectoryIterator(const DirectoryIterator &) ;                ///< \brief not copyable */
+	DirectoryIterator & operator=(const DirectoryIterator &) ;    ///< \brief not assignable */
+public:
+	static const size_t BUFFER_SIZE ;                             ///< \brief default size of the entry buffer */
+
+	DirectoryIterator(const File &directory, size_t buffer_size = BUFFER_SIZE) ;
+	DirectoryIterator(int parent_fd, const std::string &name, const std::string &path, size_t buffer_size = BUFFER_SIZE) ;
+	~DirectoryIterator() ;
+
+	const DirectoryEntry* next() ;                                ///< \brief next entry, null at end of directory */
+	iterator begin() ;                                            ///< \brief iterator to the next entry */
+	iterator end() throw() ;                                      ///< \brief end iterator */
+	void close() ;                                                ///< \brief closes the directory */
+	int release() throw() ;                                       ///< \brief gives up ownership of the descriptor */
+	int fd() const throw() ;                                      ///< \brief descriptor of the directory */
+	const std::string & path() const throw() ;                    ///< \brief path of the directory */
+    } ; // DirectoryIterator
+
+} // OksSystem
+
+#endif
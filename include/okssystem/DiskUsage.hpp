@@ -0,0 +1,63 @@
+/*
+ *  DiskUsage.h
+ *  OksSystem
+ *
+ *  Space used by directory trees.
+ *
+ */
+
+#ifndef OKSSYSTEM_DISK_USAGE
+#define OKSSYSTEM_DISK_USAGE
+
+#include <map>
+#include <string>
+
+#include <stddef.h>
+
+namespace OksSystem {
+
+    class File ;
+    class FileStatus ;
+
+    /** This class computes the space used by a directory tree, like \c du.
+      * The tree is walked in parallel with OksSystem::TreeWalker, symbolic links are not followed
+      * (they count for their own size). Files with several hard links in the tree are counted once.
+      * Besides the total, the usage of each entry of the root directory is given separately.
+      * Directories that cannot be read are skipped and counted in \c errors(): when it is not zero,
+      * the totals are partial.
+      * \brief Disk usage of a tree
+      * \see OksSystem::File::disk_usage()
+      */
+
+    class DiskUsage {
+public:
+	/** Counters for a tree or subtree */
+	struct Usage {
+	    size_t apparent_bytes ;                                   ///< \brief sum of the sizes */
+	    size_t allocated_bytes ;                                  ///< \brief sum of the allocated blocks (\c st_blocks), in bytes */
+	    size_t files ;                                            ///< \brief number of non directory entries */
+	    size_t directories ;                                      ///< \brief number of directories */
+	    size_t hard_links ;                                       ///< \brief number of additional links to files already counted */
+	    Usage() throw() ;
+	    void add(const FileStatus &status) throw() ;              ///< \brief counts a file or directory */
+	    Usage & operator+=(const Usage &other) throw() ;          ///< \brief adds the counters of another usage */
+	} ; // Usage
+	typedef std::map<std::string, Usage> usage_map_t ;
+protected:
+	Usage m_total ;                                               ///< \brief usage of the whole tree */
+	usage_map_t m_entries ;                                       ///< \brief usage of each entry of the root directory */
+	double m_elapsed_time ;                                       ///< \brief time taken by the computation (seconds) */
+	size_t m_errors ;                                             ///< \brief number of directories that could not be read */
+public:
+	DiskUsage() throw() ;
+	DiskUsage(const File &root, unsigned int workers = 0) ;       ///< \brief computes the usage of a tree */
+
+	const Usage & total() const throw() ;                         ///< \brief usage of the whole tree, including the root */
+	const usage_map_t & entries() const throw() ;                 ///< \brief usage of each entry of the root directory, by name */
+	double elapsed_time() const throw() ;                         ///< \brief time taken by the computation (seconds) */
+	size_t errors() const throw() ;                               ///< \brief number of directories skipped, the totals are partial if not zero */
+    } ; // DiskUsage
+
+} // OksSystem
+
+#endif
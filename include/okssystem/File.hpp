@@ -10,6 +10,7 @@
 #ifndef OKSSYSTEM_FILE
 #define OKSSYSTEM_FILE
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -17,6 +18,20 @@
 #include <sys/stat.h>
 
 #include "okssystem/User.hpp"
+#include "okssystem/FileStatus.hpp"
+#include "okssystem/FileFingerprint.hpp"
+#include "okssystem/FileSystemInfo.hpp"
+#include "okssystem/DirectoryEntry.hpp"
+#include "okssystem/TreeRemover.hpp"
+#include "okssystem/TreeWalker.hpp"
+#include "okssystem/DiskUsage.hpp"
+#include "okssystem/FileCopier.hpp"
+#include "okssystem/FileContent.hpp"
+#include "okssystem/AtomicWriter.hpp"
+#include "okssystem/DescriptorStreamBuf.hpp"
+#include "okssystem/TemporaryFile.hpp"
+#include "okssystem/ContentHash.hpp"
+#include "okssystem/InternedPath.hpp"
 
 namespace OksSystem {
     
@@ -24,6 +39,8 @@ namespace OksSystem {
       * it provides tools to manipulate files in a simple way. 
       * All methods throw ers issues in case of error. 
       * Internally, files are handled as canonical paths i.e with ./ ../ and symlinks resolved.
+      * Files built in \c LEXICAL mode only have ./ and ../ removed, without any system call, 
+      * symbolic links can then be resolved explicitly with \c resolve().
       * \author Matthias Wiesmann
       * \version 1.1
       * \brief Wrapper for file operations. 
@@ -32,15 +49,38 @@ namespace OksSystem {
     class File {
 public: 
 	typedef std::vector<OksSystem::File>  file_list_t ; 	
+	typedef std::vector<OksSystem::DirectoryEntry>  entry_list_t ; 
+	/** How names given to constructors are turned into full paths */
+	enum name_mode_t {
+	    CANONICAL,                                                ///< \brief ./ ../ and symlinks resolved with \c realpath */
+	    LEXICAL                                                   ///< \brief ./ and ../ removed without touching the file system */
+	} ; 
+	/** Result of a metadata query in \c stat_many() */
+	struct StatResult {
+	    int error ;                                               ///< \brief 0 on success, the \c errno value otherwise */
+	    FileStatus status ;                                       ///< \brief the status of the file, if \c error is 0 */
+	    StatResult() throw() ;
+	} ; 
+	typedef std::vector<StatResult> stat_list_t ; 
+	/** Synchronisation behaviour of metadata queries on network file systems, see \c query() */
+	enum sync_t {
+	    SYNC_AS_STAT,                                             ///< \brief same behaviour as \c stat */
+	    SYNC_FORCE,                                               ///< \brief force attributes to be synchronised with the server */
+	    SYNC_DONT                                                 ///< \brief use cached attributes if available */
+	} ; 
 protected:
-	std::string m_full_name ;                                     ///< \brief full name (path) of the file */
-	void set_name(const std::string &name);                       ///< \brief sets the name of the file */
+	InternedPath m_full_name ;                                    ///< \brief full name (path) of the file, interned */
+	void set_name(const std::string &name, name_mode_t mode = CANONICAL); ///< \brief sets the name of the file */
+	static std::string cached_working_directory() ;               ///< \brief working directory, cached for lexical names */
 	static const char * const HUMAN_SIZE_STR[] ;                  ///< \brief strings for pretty printing file sizes */
 	static const char * const HUMAN_OPEN_STR[] ;                  ///< \brief strings for pretty printing open flags */
 	static const int KILOBYTE ;                                   ///< \brief number of bytes in a kilobyte */
 	static int unit(int u) ;                                      ///< \brief calculates the value of a computer unit of order n (i.e KB,GB, etc */
 	mode_t get_mode() const ;                                     ///< \brief get mode associated with file (permission + type) */
+	static void fix_permissions(int dir_fd, const char *name, mode_t perm, bool created) ; ///< \brief sets directory permissions if needed */
+	void move_link_to(const File &destination) const ;            ///< \brief recreates a symbolic link on another file system */
 	static const char * const FILE_COMMAND_PATH ; 
+	static const size_t SNIFF_SIZE ;                              ///< \brief number of bytes read to determine the type of a file */
 public:
         static const char * const FILE_FLAG_STR ;                     ///< \brief column headers for display of permissions */
 	static const char * const FILE_PROTOCOL ;                     ///< \brief string for the file protocol */
@@ -52,18 +92,25 @@ public:
 	static int depth(const std::string &path) throw() ;            ///< \brief calculates depth of a path */
 	    
 	static std::string first_line(const std::string &text);       ///< \brief extracts the first line of a text */
+	static std::string content_type(const void *data, size_t length) ; ///< \brief type of a file from its first bytes */
 	
 	static File from_url(const std::string &url);                 ///< \brief build a file out of an URL */
 
 	static std::string working_directory() ;                      ///< \brief current directory of process */
 	static void working_directory(const File &dir);              ///< \brief set working directory of process */
 	static std::string expand_home(const std::string path) ;      ///< \brief resolve home directory */
+	static std::string normalize(const std::string &path) ;       ///< \brief removes ./ ../ and // from an absolute path */
+	static int query(const char *path, unsigned int fields, sync_t sync, FileStatus &status) throw() ; ///< \brief metadata query returning an error code */
+	static const unsigned int STAT_WORKERS ;                      ///< \brief default number of threads for \c stat_many() */
+	static stat_list_t stat_many(const File *files, size_t count, unsigned int fields = FileStatus::BASIC, unsigned int workers = 0, sync_t sync = SYNC_AS_STAT) ; ///< \brief concurrent metadata queries */
+	static stat_list_t stat_many(const file_list_t &files, unsigned int fields = FileStatus::BASIC, unsigned int workers = 0, sync_t sync = SYNC_AS_STAT) ; ///< \brief concurrent metadata queries */
 	static std::string pretty_permissions(mode_t permissions);    ///< \brief pretty prints permissions */
 	static std::string to_string(mode_t permissions) throw() ;    ///< \brief converts permission to string */
 	static std::string pretty_open_flag(int flags) ;              ///< \brief pretty prints open flags */
 	static std::string pretty_size(size_t size, bool cut_small);  ///< \brief pretty prints a file size */
 	    
 	File(const std::string &name); 
+	File(const std::string &name, name_mode_t mode); 
 	File(const char* name) ; 
 	File(const File& other) ; 
 	virtual ~File() {} 
@@ -71,6 +118,8 @@ public:
 	operator const char* () const throw() ; 
 	operator bool() const throw() ;     
 	bool equals(const File &other) const throw() ;                ///< \brief compare two files */
+	size_t hash() const throw() ;                                 ///< \brief hash of the path of the file */
+	std::string hash(ContentHash::algorithm_t algorithm, unsigned int workers = 0) const ; ///< \brief digest of the content of the file */
 	operator size_t() const ; 
 	
 	const std::string &full_name() const throw() ;                ///< \brief full name for file */
@@ -80,37 +129,65 @@ public:
 	std::string extension() const throw();                        ///< \brief extension for file */
 	int depth() const throw() ;                                   ///< \brief depth of the file */
     
+	OksSystem::File resolve() const ;                                ///< \brief canonical version of the file (symlinks resolved) */
 	OksSystem::File parent() const ;                                 ///< \brief parent of the current file */
 	OksSystem::File child(const std::string &name) const ;           ///< \brief named child of the current directory */
+	OksSystem::File child(const std::string &name, name_mode_t mode) const ; ///< \brief named child, with explicit name mode */
+	[[deprecated("racy (tempnam), use make_temporary()")]] 
 	OksSystem::File temporary(const std::string &prefix) const ; 
+	TemporaryFile make_temporary(const std::string &prefix, bool named = false, mode_t permissions = 0600) const ; ///< \brief creates and opens a temporary file in the directory */
 	
 	bool exists() const throw() ;                                 ///< \brief does the file exist */
+	FileId id() const ;                                           ///< \brief identity of the file (device and inode) */
+	FileStatus status() const ;                                   ///< \brief snapshot of the file metadata (single stat) */
+	FileStatus query(unsigned int fields, sync_t sync = SYNC_AS_STAT) const ; ///< \brief partial snapshot of the file metadata */
+	FileStatus link_status() const ;                              ///< \brief snapshot of the metadata, symbolic links not followed */
+	bool is_symlink() const ;                                     ///< \brief is the file a symbolic link */
+	std::string link_target() const ;                             ///< \brief contents of a symbolic link */
+	FileFingerprint fingerprint() const ;                         ///< \brief metadata fingerprint, for change detection */
+	bool unchanged_since(const FileFingerprint &fingerprint) const throw() ; ///< \brief is the file still as fingerprinted */
+	FileSystemInfo filesystem(double max_age = FileSystemInfo::CACHE_TIME) const ; ///< \brief information about the file system of the file */
 	mode_t permissions() const ;                                  ///< \brief permissions for the file */
 	std::string pretty_permissions() const ;                      ///< \brief pretty permissions for the file */
 	size_t size() const ;                                         ///< \brief size of file */
 	uid_t owner_id() const ;                                      ///< \brief owner id of file */
 	User owner() const ;                                          ///< \brief owner of the file */
 	gid_t group() const ;                                         ///< \brief group of file */
-	bool is_regular() const ;                                     ///< \brief is the file a directory */
-	bool is_directory() const ;                                   ///< \brief is the file a regular file */
+	bool is_regular() const ;                                     ///< \brief is the file a regular file */
+	bool is_directory() const ;                                   ///< \brief is the file a directory */
 	bool is_fifo() const ;                                        ///< \brief is the file a named pipe */
 	std::string file_type() const ;                               ///< \brief type of the file */
 	file_list_t directory() const ;                               ///< \brief list of file in directory */
+	entry_list_t entries() const ;                                ///< \brief list of raw entries in directory */
+	DiskUsage disk_usage(unsigned int workers = 0) const ;        ///< \brief space used by the file or directory tree */
+	entry_list_t find(const std::string &pattern, unsigned int workers = 0) const ; ///< \brief entries of the tree whose name matches a pattern */
 	
 	void unlink() const ;                                         ///< \brief deletes (unlinks) file */
 	void rmdir() const ;                                          ///< \brief deletes directory */
 
 	void remove() const ;                                         ///< \brief recursively delete files and directories */
+	TreeRemover::Statistics remove_tree(unsigned int workers = 0) const ; ///< \brief recursively delete files and directories in parallel */
 	void rename(const File &other) const ;                        ///< \brief rename or moves the file */
+	FileCopier::Statistics copy_to(const File &destination, const FileCopier::progress_t &progress = FileCopier::progress_t()) const ; ///< \brief copies the file */
+	FileCopier::Statistics move_to(const File &destination, const FileCopier::progress_t &progress = FileCopier::progress_t()) const ; ///< \brief moves the file, across file systems if needed */
 	void permissions(mode_t permissions) const ;                  ///< \brief sets the type of the file */
 	void make_dir(mode_t permissions) const ;                     ///< \brief creates a directory */
 	void make_path(mode_t permissions) const ;                    ///< \brief creates a full path */
 	void make_fifo(mode_t permissions) const ;                    ///< \brief creates a FIFO (named pipe) */
 	
 	void ensure_path(mode_t permissions) const ;                  ///< \brief creates the parent path */
+	void reserve(size_t bytes) const ;                            ///< \brief allocates disk space beyond the end of the file */
+	void unreserve() const ;                                      ///< \brief releases the disk space allocated beyond the end of the file */
 	
 	std::istream* input() const ;                                 ///< \brief returns an input stream from the file*/
+	FileContent content(size_t threshold = FileContent::MAP_THRESHOLD) const ; ///< \brief whole content of the file, read or mapped */
 	std::ostream* output(bool append=false) const ;               ///< \brief returns an output stream to the file*/
+	std::ostream* output(bool append, size_t reserve) const ;     ///< \brief returns an output stream to the file, with space reserved */
+	DescriptorInputStream* input(const DescriptorStreamBuf::Options &options) const ; ///< \brief returns a buffered input stream on a descriptor */
+	DescriptorOutputStream* output(bool append, const DescriptorStreamBuf::Options &options) const ; ///< \brief returns a buffered output stream on a descriptor */
+	AtomicWriter atomic_writer(mode_t permissions = AtomicWriter::KEEP_PERMISSIONS, AtomicWriter::SyncBatch *batch = 0) const ; ///< \brief writer replacing the file atomically */
+	void atomic_write(const void *data, size_t size, mode_t permissions = AtomicWriter::KEEP_PERMISSIONS, AtomicWriter::SyncBatch *batch = 0) const ; ///< \brief replaces the content of the file atomically */
+	void atomic_write(std::string_view data, mode_t permissions = AtomicWriter::KEEP_PERMISSIONS, AtomicWriter::SyncBatch *batch = 0) const ; ///< \brief replaces the content of the file atomically */
     } ; // File
 } // OksSystem
 
@@ -118,6 +195,19 @@ std::ostream& operator<<(std::ostream& stream, const OksSystem::File& file);
 bool operator ==(const OksSystem::File &a, const OksSystem::File &b)  throw(); 
 bool operator !=(const OksSystem::File &a, const OksSystem::File &b)  throw(); 
 
+namespace std {
+
+    template<> struct hash<OksSystem::File> {
+	size_t operator()(const OksSystem::File &file) const throw() { return file.hash() ; }
+    } ; 
+
+    /** The comparison operators of File are global, they are not found by lookup from namespace std */
+    template<> struct equal_to<OksSystem::File> {
+	bool operator()(const OksSystem::File &a, const OksSystem::File &b) const throw() { return a.equals(b) ; }
+    } ; 
+
+} // std
+
 
 #endif
 
@@ -0,0 +1,67 @@
+/*
+ *  FileContent.h
+ *  OksSystem
+ *
+ *  Read-only view of the whole content of a file.
+ *
+ */
+
+#ifndef OKSSYSTEM_FILE_CONTENT
+#define OKSSYSTEM_FILE_CONTENT
+
+#include <string>
+#include <string_view>
+
+#include <stddef.h>
+
+namespace OksSystem {
+
+    class File ;
+
+    /** This class gives access to the whole content of a file as one contiguous, read-only block of memory.
+      * Small files are read into a buffer with a single \c read sized from \c fstat,
+      * files of at least \c threshold bytes are mapped in memory through the descriptor already opened and checked with \c fstat,
+      * so that no copy is made and only the pages actually accessed are read.
+      * The content is a snapshot for read files, a mapped file must not be truncated while it is in use.
+      * Files whose size is not known in advance (like files in \c /proc) are read until the end.
+      * \code
+      * const OksSystem::FileContent content = OksSystem::File("config.xml").content();
+      * std::string_view text = content.view();
+      * \endcode
+      * \brief Whole file content
+      * \see OksSystem::File::content()
+      */
+
+    class FileContent {
+public:
+	static const size_t MAP_THRESHOLD ;                           ///< \brief default size from which files are mapped */
+protected:
+	std::string m_buffer ;                                        ///< \brief content of a read file */
+	void *m_map ;                                                 ///< \brief address of the mapped file, null if the file was read */
+	size_t m_map_size ;                                           ///< \brief size of the mapping */
+	const char *m_data ;                                          ///< \brief start of the content */
+	size_t m_size ;                                               ///< \brief size of the content */
+	void read(int fd, size_t size, const std::string &name) ;    ///< \brief reads the file into the buffer */
+	void map(int fd, size_t size, const std::string &name) ;     ///< \brief maps the file */
+	void release() throw() ;                                      ///< \brief unmaps the file, if mapped */
+private:
+	FileContent(const FileContent &) ;                            ///< \brief not copyable */
+	FileContent & operator=(const FileContent &) ;                ///< \brief not assignable */
+public:
+	explicit FileContent(const File &file, size_t threshold = MAP_THRESHOLD) ;
+	FileContent(FileContent &&other) throw() ;
+	~FileContent() ;
+
+	const char *data() const throw() { return m_data ; }          ///< \brief start of the content */
+	size_t size() const throw() { return m_size ; }               ///< \brief size of the content */
+	bool empty() const throw() { return 0==m_size ; }             ///< \brief is the file empty */
+	const char *begin() const throw() { return m_data ; }         ///< \brief start of the content */
+	const char *end() const throw() { return m_data+m_size ; }    ///< \brief end of the content */
+	std::string_view view() const throw() { return std::string_view(m_data,m_size) ; } ///< \brief the content as a string view */
+	std::string str() const { return std::string(m_data,m_size) ; } ///< \brief copy of the content */
+	bool is_mapped() const throw() { return m_map!=0 ; }          ///< \brief is the file mapped in memory */
+    } ; // FileContent
+
+} // OksSystem
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ *  FileCopier.h
+ *  OksSystem
+ *
+ *  Kernel side copy of files.
+ *
+ */
+
+#ifndef OKSSYSTEM_FILE_COPIER
+#define OKSSYSTEM_FILE_COPIER
+
+#include <functional>
+
+#include <stddef.h>
+#include <sys/types.h>
+
+namespace OksSystem {
+
+    class File ;
+
+    /** This class copies regular files, keeping the data in the kernel whenever possible.
+      * The methods are tried in order: a reflink (\c FICLONE, the copy shares the blocks of the source
+      * on file systems like btrfs or xfs), \c copy_file_range (which can be offloaded to the server on NFS),
+      * \c sendfile, and finally a read / write loop. 
+      * Only the data segments of sparse files are copied (\c SEEK_DATA / \c SEEK_HOLE), so holes are kept. 
+      * The destination gets the permissions of the source. The copy is written to a temporary file
+      * renamed over the destination when complete, so the destination holds either its previous content or the full copy.
+      * \brief File copy
+      * \see OksSystem::File::copy_to()
+      * \see OksSystem::File::move_to()
+      */
+
+    class FileCopier {
+public:
+	/** Method used to copy the data, from the most to the least efficient */
+	enum method_t {
+	    CLONE,                                                    ///< \brief reflink, no data copied */
+	    COPY_FILE_RANGE,                                          ///< \brief copy inside the kernel (or on the server) */
+	    SENDFILE,                                                 ///< \brief copy inside the kernel, through the page cache */
+	    BUFFERED                                                  ///< \brief copy through a user space buffer */
+	} ; 
+	/** Function called as the copy progresses, with the number of bytes copied so far and the total */
+	typedef std::function<void(size_t copied, size_t total)> progress_t ;
+
+	/** Result of a copy */
+	struct Statistics {
+	    size_t bytes ;                                            ///< \brief size of the file */
+	    size_t data_bytes ;                                       ///< \brief bytes actually copied (holes excluded) */
+	    method_t method ;                                         ///< \brief least efficient method used */
+	    double elapsed_time ;                                     ///< \brief wall clock time of the copy (seconds) */
+	    Statistics() throw() ;
+	} ; // Statistics
+
+	static const size_t CHUNK_SIZE ;                              ///< \brief bytes copied between progress reports */
+	static const size_t BUFFER_SIZE ;                             ///< \brief size of the buffer of the read / write loop */
+protected:
+	progress_t m_progress ;                                       ///< \brief progress callback, can be empty */
+	method_t m_method ;                                           ///< \brief most efficient method to try */
+	method_t copy_range(int source_fd, int dest_fd, off_t offset, size_t length, method_t method, size_t &copied, size_t total) const ; ///< \brief copies a data segment */
+public:
+	FileCopier(const progress_t &progress = progress_t(), method_t method = CLONE) ;
+
+	Statistics copy(const File &source, const File &destination) const ; ///< \brief copies a file */
+	static const char *method_name(method_t method) throw() ;     ///< \brief name of a copy method */
+    } ; // FileCopier
+
+} // OksSystem
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ *  FileFingerprint.h
+ *  OksSystem
+ *
+ *  Cheap change detection for files, based on their metadata.
+ *
+ */
+
+#ifndef OKSSYSTEM_FILE_FINGERPRINT
+#define OKSSYSTEM_FILE_FINGERPRINT
+
+#include <stdint.h>
+
+#include "okssystem/FileId.hpp"
+
+namespace OksSystem {
+
+    class FileStatus ;
+
+    /** This class summarises the metadata that changes when a file is modified or replaced:
+      * identity (device and inode), size, and modification and status change times in nanoseconds.
+      * Comparing two fingerprints of a file tells if it was changed in between without reading it.
+      * Replacing a file by renaming a new one over it changes the inode, 
+      * writing to it changes the times (and usually the size).
+      * The times only change when the clock of the file system ticks, a file rewritten with the same size
+      * within the same tick (up to two seconds on some file systems) keeps its fingerprint.
+      * A fingerprint whose times are not older than the moment it was taken by at least \c RACY_NS is "racy"
+      * (as git calls it): it cannot prove that the file is unchanged, and must be taken again later.
+      * \brief Metadata fingerprint of a file
+      * \see OksSystem::File::fingerprint()
+      * \see OksSystem::FingerprintCache
+      */
+
+    class FileFingerprint {
+protected:
+	FileId m_id ;                                                 ///< \brief device and inode */
+	size_t m_size ;                                               ///< \brief size in bytes */
+	int64_t m_modification_ns ;                                   ///< \brief modification time (nanoseconds since the epoch) */
+	int64_t m_change_ns ;                                         ///< \brief status change time (nanoseconds since the epoch) */
+public:
+	static const unsigned int FIELDS ;                            ///< \brief status fields needed to build a fingerprint */
+	static const int64_t RACY_NS ;                                ///< \brief coarsest timestamp granularity handled, in nanoseconds */
+	static int64_t clock_ns() throw() ;                           ///< \brief current time in nanoseconds, to compare with the fingerprint times */
+
+	FileFingerprint() throw() ;                                   ///< \brief null fingerprint, matches no file */
+	FileFingerprint(const FileStatus &status) throw() ;           ///< \brief fingerprint from a status */
+
+	const FileId & id() const throw() ;                           ///< \brief device and inode */
+	size_t size() const throw() ;                                 ///< \brief size in bytes */
+	int64_t modification_ns() const throw() ;                     ///< \brief modification time in nanoseconds */
+	int64_t change_ns() const throw() ;                           ///< \brief status change time in nanoseconds */
+	bool racy(int64_t taken_ns) const throw() ;                   ///< \brief could a change in the same tick go unnoticed */
+	operator bool() const throw() ;                               ///< \brief is the fingerprint not null */
+	bool operator==(const FileFingerprint &other) const throw() ;
+	bool operator!=(const FileFingerprint &other) const throw() ;
+    } ; // FileFingerprint
+
+} // OksSystem
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ *  FileId.h
+ *  OksSystem
+ *
+ *  Identity of a file on the local system (device and inode numbers).
+ *
+ */
+
+#ifndef OKSSYSTEM_FILE_ID
+#define OKSSYSTEM_FILE_ID
+
+#include <functional>
+
+#include <sys/types.h>
+
+namespace OksSystem {
+
+    /** This class identifies a file by its device and inode numbers.
+      * Contrary to paths, two hard links to the same file have the same identity,
+      * so this can be used to detect files reached through different names.
+      * Identities are only meaningful while the file exists, inode numbers can be reused.
+      * \brief Device and inode pair
+      * \see OksSystem::FileStatus::id()
+      * \see OksSystem::DirectoryEntry::id()
+      */
+
+    class FileId {
+protected:
+	dev_t m_device ;                                              ///< \brief device containing the file */
+	ino_t m_inode ;                                               ///< \brief inode number of the file on the device */
+public:
+	FileId() throw() ;                                            ///< \brief null identity */
+	FileId(dev_t device, ino_t inode) throw() ;
+
+	dev_t device() const throw() ;                                ///< \brief device containing the file */
+	ino_t inode() const throw() ;                                 ///< \brief inode number */
+	size_t hash() const throw() ;                                 ///< \brief hash of the identity */
+	operator bool() const throw() ;                               ///< \brief is the identity not null */
+	bool operator==(const FileId &other) const throw() ;
+	bool operator!=(const FileId &other) const throw() ;
+	bool operator<(const FileId &other) const throw() ;
+    } ; // FileId
+
+} // OksSystem
+
+namespace std {
+
+    template<> struct hash<OksSystem::FileId> {
+	size_t operator()(const OksSystem::FileId &id) const throw() { return id.hash() ; }
+    } ; 
+
+} // std
+
+#endif
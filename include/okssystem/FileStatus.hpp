@@ -0,0 +1,84 @@
+/*
+ *  FileStatus.h
+ *  OksSystem
+ *
+ *  Snapshot of the metadata of a file, obtained with a single stat call.
+ *
+ */
+
+#ifndef OKSSYSTEM_FILE_STATUS
+#define OKSSYSTEM_FILE_STATUS
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "okssystem/FileId.hpp"
+
+namespace OksSystem {
+
+    /** This class represents the status (metadata) of a file at a given time.
+      * It is a simple value type wrapping a \c struct \c stat, so that callers needing
+      * several attributes of a file (type, size, owner...) only pay for one \c stat call.
+      * The snapshot is not refreshed: it describes the file as it was when it was taken.
+      * A status obtained through OksSystem::File::query() may only contain a subset of the fields,
+      * the fields actually filled can be checked with \c has().
+      * \brief Snapshot of file metadata
+      * \see OksSystem::File::status()
+      */
+
+    class FileStatus {
+public:
+	/** Fields of the status, the values match the \c STATX_ masks of the Linux \c statx call */
+	enum field_t {
+	    TYPE   = 0x0001,                                          ///< \brief file type (part of mode) */
+	    MODE   = 0x0002,                                          ///< \brief permissions (part of mode) */
+	    NLINK  = 0x0004,                                          ///< \brief number of hard links */
+	    UID    = 0x0008,                                          ///< \brief owner id */
+	    GID    = 0x0010,                                          ///< \brief group id */
+	    ATIME  = 0x0020,                                          ///< \brief last access time */
+	    MTIME  = 0x0040,                                          ///< \brief last modification time */
+	    CTIME  = 0x0080,                                          ///< \brief last status change time */
+	    INO    = 0x0100,                                          ///< \brief inode number */
+	    SIZE   = 0x0200,                                          ///< \brief size in bytes */
+	    BLOCKS = 0x0400,                                          ///< \brief number of allocated blocks */
+	    BASIC  = 0x07ff,                                          ///< \brief all the fields returned by \c stat */
+	    BTIME  = 0x0800,                                          ///< \brief creation (birth) time */
+	    ALL    = 0x0fff                                           ///< \brief all the fields above */
+	} ; 
+protected:
+	struct stat m_stat ;                                          ///< \brief raw status information */
+	struct timespec m_birth_time ;                                ///< \brief creation time, if available */
+	unsigned int m_fields ;                                       ///< \brief mask of the fields actually filled */
+public:
+	FileStatus() throw() ;                                        ///< \brief empty (zeroed) status */
+	FileStatus(const struct stat &status) throw() ;               ///< \brief status from raw stat data */
+	FileStatus(const struct stat &status, unsigned int fields, const struct timespec &birth) throw() ; ///< \brief partial status */
+
+	unsigned int fields() const throw() ;                         ///< \brief mask of the fields filled */
+	bool has(unsigned int fields) const throw() ;                 ///< \brief are all the given fields filled */
+
+	const struct stat & stat() const throw() ;                    ///< \brief raw status information */
+	mode_t mode() const throw() ;                                 ///< \brief mode of the file (permission + type) */
+	mode_t permissions() const throw() ;                          ///< \brief permissions for the file */
+	size_t size() const throw() ;                                 ///< \brief size of file */
+	uid_t owner_id() const throw() ;                              ///< \brief owner id of file */
+	gid_t group() const throw() ;                                 ///< \brief group of file */
+	dev_t device() const throw() ;                                ///< \brief device containing the file */
+	ino_t inode() const throw() ;                                 ///< \brief inode number of the file */
+	FileId id() const throw() ;                                   ///< \brief identity of the file (device and inode) */
+	nlink_t links() const throw() ;                               ///< \brief number of hard links */
+	blkcnt_t blocks() const throw() ;                             ///< \brief number of 512 bytes blocks allocated */
+	blksize_t block_size() const throw() ;                        ///< \brief preferred block size for I/O */
+	const struct timespec & modification_time() const throw() ;   ///< \brief time of last modification */
+	const struct timespec & change_time() const throw() ;         ///< \brief time of last status change */
+	const struct timespec & access_time() const throw() ;         ///< \brief time of last access */
+	const struct timespec & birth_time() const throw() ;          ///< \brief time of creation (if \c BTIME is filled) */
+	bool is_regular() const throw() ;                             ///< \brief is the file a regular file */
+	bool is_directory() const throw() ;                           ///< \brief is the file a directory */
+	bool is_fifo() const throw() ;                                ///< \brief is the file a named pipe */
+	bool is_symlink() const throw() ;                             ///< \brief is the file a symbolic link (\c lstat status only) */
+    } ; // FileStatus
+
+} // OksSystem
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ *  FileSystemInfo.h
+ *  OksSystem
+ *
+ *  Capacity and properties of a mounted file system.
+ *
+ */
+
+#ifndef OKSSYSTEM_FILE_SYSTEM_INFO
+#define OKSSYSTEM_FILE_SYSTEM_INFO
+
+#include <string>
+
+#include <sys/types.h>
+#include <sys/statvfs.h>
+#include <time.h>
+
+namespace OksSystem {
+
+    class File ;
+
+    /** This class describes the file system containing a file, as reported by \c statvfs and \c statfs.
+      * Like OksSystem::FileStatus it is a snapshot, sizes are expressed in bytes.
+      * Information obtained through \c get() is cached per device for a short time,
+      * so that writers checking the free space before each output do not each pay for a
+      * (possibly remote) \c statfs call.
+      * \brief File system information
+      * \see OksSystem::File::filesystem()
+      */
+
+    class FileSystemInfo {
+protected:
+	struct statvfs m_stat ;                                       ///< \brief raw \c statvfs information */
+	unsigned long m_type ;                                        ///< \brief file system magic number (\c statfs \c f_type) */
+	dev_t m_device ;                                              ///< \brief device of the file system */
+	struct timespec m_time ;                                      ///< \brief when the information was obtained (monotonic clock) */
+	static double age(const struct timespec &time) throw() ;      ///< \brief seconds elapsed since a monotonic time */
+public:
+	static const double CACHE_TIME ;                              ///< \brief default time information is kept in the cache (seconds) */
+
+	static FileSystemInfo get(const File &file, double max_age = CACHE_TIME) ; ///< \brief information for the file system of a file, cached */
+	static void invalidate() ;                                    ///< \brief empties the cache */
+
+	FileSystemInfo() throw() ;                                    ///< \brief empty (zeroed) information */
+	FileSystemInfo(const File &file) ;                            ///< \brief queries the file system of a file */
+
+	dev_t device() const throw() ;                                ///< \brief device of the file system */
+	double age() const throw() ;                                  ///< \brief seconds since the information was obtained */
+	size_t block_size() const throw() ;                           ///< \brief preferred block size for I/O */
+	size_t fragment_size() const throw() ;                        ///< \brief allocation unit of the file system */
+	size_t total_bytes() const throw() ;                          ///< \brief size of the file system */
+	size_t free_bytes() const throw() ;                           ///< \brief free space (including space reserved for root) */
+	size_t available_bytes() const throw() ;                      ///< \brief free space for unprivileged users */
+	size_t total_inodes() const throw() ;                         ///< \brief number of inodes */
+	size_t free_inodes() const throw() ;                          ///< \brief number of free inodes */
+	size_t available_inodes() const throw() ;                     ///< \brief free inodes for unprivileged users */
+	size_t max_name_length() const throw() ;                      ///< \brief maximum length of a file name */
+	unsigned long type() const throw() ;                          ///< \brief file system magic number */
+	std::string type_name() const ;                               ///< \brief name of the file system type */
+	unsigned long flags() const throw() ;                         ///< \brief mount flags (\c ST_ constants) */
+	bool is_read_only() const throw() ;                           ///< \brief is the file system mounted read only */
+	bool has_space(size_t bytes) const throw() ;                  ///< \brief are \c bytes available for unprivileged users */
+    } ; // FileSystemInfo
+
+} // OksSystem
+
+#endif
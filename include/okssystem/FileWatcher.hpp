@@ -0,0 +1,100 @@
+/*
+ *  FileWatcher.h
+ *  OksSystem
+ *
+ *  Notification of changes to files and directories (inotify).
+ *
+ */
+
+#ifndef OKSSYSTEM_FILE_WATCHER
+#define OKSSYSTEM_FILE_WATCHER
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "okssystem/File.hpp"
+
+namespace OksSystem {
+
+    /** This class reports changes to files and directories as they happen, using Linux \c inotify,
+      * instead of polling \c File::exists() or \c File::size() in a loop.
+      * Watching a directory reports the events of its entries (a file or FIFO created, written, closed, moved or removed),
+      * watching a file reports the events of the file itself.
+      * The events read together are coalesced: each file appears once per batch, with the mask of all its events.
+      * Events can be obtained in three ways: by polling the descriptor \c fd() and calling \c read(),
+      * by waiting for an event on a given file with \c wait_for(), or by a callback called from a thread started with \c start().
+      * \code
+      * OksSystem::FileWatcher watcher;
+      * watcher.watch(OksSystem::File("/data/raw"));
+      * watcher.start([](const OksSystem::FileWatcher::Event &event) {
+      *     if (event.has(OksSystem::FileWatcher::CLOSED_WRITE)) process(event.file);
+      * });
+      * \endcode
+      * \brief File and directory watcher
+      */
+
+    class FileWatcher {
+public:
+	/** Events, the values match the \c IN_ masks of \c inotify */
+	enum event_t {
+	    MODIFIED     = 0x0002,                                    ///< \brief data written */
+	    CLOSED_WRITE = 0x0008,                                    ///< \brief closed after being opened for writing */
+	    MOVED_FROM   = 0x0040,                                    ///< \brief moved out of the watched directory */
+	    MOVED_TO     = 0x0080,                                    ///< \brief moved into the watched directory */
+	    CREATED      = 0x0100,                                    ///< \brief created in the watched directory */
+	    DELETED      = 0x0200,                                    ///< \brief removed from the watched directory */
+	    DELETED_SELF = 0x0400,                                    ///< \brief the watched file itself was removed */
+	    MOVED_SELF   = 0x0800,                                    ///< \brief the watched file itself was moved */
+	    DEFAULT      = 0x0fca,                                    ///< \brief all the events above */
+	    QUEUE_OVERFLOW = 0x4000                                   ///< \brief events were lost, all the watched files should be checked again */
+	} ;
+
+	/** A file and the events that happened to it */
+	struct Event {
+	    File file ;                                               ///< \brief the file */
+	    unsigned int events ;                                     ///< \brief mask of the events */
+	    bool is_directory ;                                       ///< \brief is the file a directory */
+	    Event(const File &f, unsigned int e, bool d) : file(f), events(e), is_directory(d) {}
+	    bool has(unsigned int mask) const throw() { return 0!=(events & mask) ; } ///< \brief did one of the events happen */
+	} ; // Event
+	typedef std::vector<Event> event_list_t ;
+	typedef std::function<void(const Event &event)> callback_t ;
+
+	static const size_t BUFFER_SIZE ;                             ///< \brief size of the buffer for reading events */
+protected:
+	int m_fd ;                                                    ///< \brief inotify descriptor */
+	int m_stop_fd ;                                               ///< \brief event descriptor waking up the callback thread */
+	std::mutex m_mutex ;                                          ///< \brief protects the watches */
+	std::map<int, std::string> m_paths ;                          ///< \brief path of each watch descriptor */
+	std::unordered_map<std::string, int> m_watches ;              ///< \brief watch descriptor of each path */
+	std::thread m_thread ;                                        ///< \brief callback thread */
+	std::atomic<bool> m_running ;                                 ///< \brief is the callback thread running */
+	std::atomic<bool> m_stopping ;                                ///< \brief was the callback thread asked to stop */
+	void run(callback_t callback) ;                               ///< \brief body of the callback thread */
+	void decode(const char *buffer, size_t size, event_list_t &events, std::unordered_map<std::string, size_t> &index) ; ///< \brief decodes and coalesces raw events */
+private:
+	FileWatcher(const FileWatcher &) ;                            ///< \brief not copyable */
+	FileWatcher & operator=(const FileWatcher &) ;                ///< \brief not assignable */
+public:
+	FileWatcher() ;
+	~FileWatcher() ;
+
+	void watch(const File &file, unsigned int events = DEFAULT) ; ///< \brief starts watching a file or directory */
+	void unwatch(const File &file) ;                              ///< \brief stops watching a file or directory */
+	bool is_watched(const File &file) ;                           ///< \brief is a file or directory watched */
+	int fd() const throw() ;                                      ///< \brief descriptor to poll for events */
+	size_t read(event_list_t &events, int timeout = 0) ;          ///< \brief reads the pending events */
+	bool wait_for(const File &file, unsigned int events, int timeout) ; ///< \brief waits for an event on a file */
+	void start(const callback_t &callback) ;                      ///< \brief starts the callback thread */
+	void stop() ;                                                 ///< \brief stops the callback thread */
+    } ; // FileWatcher
+
+} // OksSystem
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ *  FingerprintCache.h
+ *  OksSystem
+ *
+ *  Process wide cache of file fingerprints and of content derived from files.
+ *
+ */
+
+#ifndef OKSSYSTEM_FINGERPRINT_CACHE
+#define OKSSYSTEM_FINGERPRINT_CACHE
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+
+#include "okssystem/File.hpp"
+#include "okssystem/FileFingerprint.hpp"
+
+namespace OksSystem {
+
+    /** This class remembers the fingerprint of files, and content derived from them
+      * (parsed configuration, hashes...), so that it is only computed again when the file changes.
+      * Checking a file costs a single \c statx call, the file itself is only read by the loader 
+      * when its fingerprint differs from the one recorded with the content.
+      * \code
+      * std::shared_ptr<const Config> config = OksSystem::FingerprintCache::instance().memoize<Config>(file,"config",
+      *     [](const OksSystem::File &f) { return std::make_shared<const Config>(parse(f)); });
+      * \endcode
+      * The fingerprint is taken before the loader runs, so a modification during loading is detected by 
+      * the next call. A fingerprint taken while the file times are recent is racy (see \c FileFingerprint::racy()):
+      * a same size rewrite in the same clock tick would not change it, so content recorded with it
+      * is loaded again on the next call, until the fingerprint is old enough to be trusted. The cache is thread safe, loaders run without holding any lock 
+      * (two threads missing at the same time may both load).
+      * \brief Change detection and memoization for files
+      * \see OksSystem::FileFingerprint
+      */
+
+    class FingerprintCache {
+protected:
+	typedef std::pair<std::string, std::type_index> key_t ;
+	/** What is known about one file */
+	struct Record {
+	    FileFingerprint m_fingerprint ;                           ///< \brief fingerprint of the file when the content was derived */
+	    std::map<key_t, std::shared_ptr<const void> > m_content ; ///< \brief derived content */
+	    bool m_racy = false ;                                     ///< \brief the fingerprint was too recent to prove the content current */
+	} ; // Record
+	std::mutex m_mutex ;                                          ///< \brief protects the records */
+	std::unordered_map<File, Record> m_records ;                  ///< \brief records, indexed by file */
+
+	std::shared_ptr<const void> lookup(const File &file, const key_t &key, const FileFingerprint &current) ;
+	void store(const File &file, const key_t &key, const FileFingerprint &current, int64_t taken_ns, const std::shared_ptr<const void> &content) ;
+	bool record(const File &file, const FileFingerprint &current, int64_t taken_ns) ;
+	FingerprintCache() ;
+private:
+	FingerprintCache(const FingerprintCache &) ;                  ///< \brief not copyable */
+	FingerprintCache & operator=(const FingerprintCache &) ;      ///< \brief not assignable */
+public:
+	static FingerprintCache & instance() ;                        ///< \brief the process wide cache */
+
+	FileFingerprint fingerprint(const File &file) ;               ///< \brief current fingerprint, recorded in the cache */
+	bool changed(const File &file) ;                              ///< \brief has the file changed since last recorded */
+	void forget(const File &file) ;                               ///< \brief drops what is known about a file */
+	void clear() ;                                                ///< \brief drops everything */
+	size_t size() ;                                               ///< \brief number of files in the cache */
+
+	/** Returns content derived from a file, computing it only if the file changed.
+	  * \param file the file
+	  * \param key name of the content, several contents can be attached to the same file
+	  * \param loader function computing the content from the file
+	  * \return the content, as returned by the loader now or on a previous call
+	  * \exception OksSystem::OksSystemCallIssue if the file cannot be queried
+	  * \exception any exception thrown by the loader, nothing is recorded in that case 
+	  */
+	template <class T> std::shared_ptr<const T> memoize(const File &file, const std::string &key, const std::function<std::shared_ptr<const T>(const File &)> &loader) {
+	    const key_t k(key,std::type_index(typeid(T)));
+	    const int64_t taken = FileFingerprint::clock_ns();
+	    const FileFingerprint current(file.query(FileFingerprint::FIELDS));
+	    std::shared_ptr<const void> content = lookup(file,k,current);
+	    if (! content) {
+		content = loader(file);
+		store(file,k,current,taken,content);
+	    } // if
+	    return std::static_pointer_cast<const T>(content);
+	} // memoize
+    } ; // FingerprintCache
+
+} // OksSystem
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ *  InternedPath.h
+ *  OksSystem
+ *
+ *  Compact shared handle on a path stored in a process wide table.
+ *
+ */
+
+#ifndef OKSSYSTEM_INTERNED_PATH
+#define OKSSYSTEM_INTERNED_PATH
+
+#include <atomic>
+#include <string>
+
+namespace OksSystem {
+
+    /** This class is a handle on a path stored in a process wide, thread safe table.
+      * Each distinct path is stored only once, however many handles refer to it,
+      * so copying a handle or comparing two handles does not depend on the length of the path.
+      * The table entry is reference counted and freed when the last handle is destroyed.
+      * \brief Interned path handle
+      * \see OksSystem::File
+      */
+
+    class InternedPath {
+public:
+	/** Entry of the path table */
+	struct Entry {
+	    std::string m_path ;                                      ///< \brief the path */
+	    size_t m_hash ;                                           ///< \brief hash of the path */
+	    std::atomic<size_t> m_references ;                        ///< \brief number of handles on the entry */
+	    Entry(const std::string &path, size_t hash) : m_path(path), m_hash(hash), m_references(1) {}
+	} ; // Entry
+protected:
+	Entry *m_entry ;                                              ///< \brief entry in the table, null for the empty path */
+	static const std::string EMPTY ;                              ///< \brief the empty path */
+	void release() throw() ;                                      ///< \brief drops the reference on the entry */
+public:
+	static size_t table_size() ;                                  ///< \brief number of distinct paths in the table */
+
+	InternedPath() throw() ;
+	explicit InternedPath(const std::string &path) ;
+	InternedPath(const InternedPath &other) throw() ;
+	~InternedPath() ;
+	InternedPath & operator=(const InternedPath &other) throw() ;
+
+	const std::string & str() const throw() { return m_entry ? m_entry->m_path : EMPTY ; }  ///< \brief the path */
+	const char* c_str() const throw() { return str().c_str() ; }                              ///< \brief the path as a C string */
+	size_t size() const throw() { return str().size() ; }                                     ///< \brief length of the path */
+	size_t hash() const throw() ;                                                            ///< \brief hash of the path */
+	bool operator==(const InternedPath &other) const throw() { return m_entry==other.m_entry ; } ///< \brief equality (handle comparison) */
+	bool operator!=(const InternedPath &other) const throw() { return m_entry!=other.m_entry ; } ///< \brief inequality (handle comparison) */
+    } ; // InternedPath
+
+} // OksSystem
+
+#endif
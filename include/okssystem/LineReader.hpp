@@ -0,0 +1,80 @@
+/*
+ *  LineReader.h
+ *  OksSystem
+ *
+ *  Fast line by line reading of text files.
+ *
+ */
+
+#ifndef OKSSYSTEM_LINE_READER
+#define OKSSYSTEM_LINE_READER
+
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include <stddef.h>
+
+#include "okssystem/File.hpp"
+
+namespace OksSystem {
+
+    /** This class iterates over the lines of a text file without copying them,
+      * each line is given as a \c std::string_view on the content of the file.
+      * The file is either held in memory as a whole (mapped when it is large,
+      * through OksSystem::FileContent), or read in large blocks through its descriptor,
+      * which is used for pipes and special files, and keeps the memory used bounded.
+      * Line ends are found with \c memchr, which the C library implements with vector instructions.
+      * As with \c std::getline, the line end character is not part of the line, and a last line
+      * without line end is still a line.
+      * Very large files can be processed in parallel with \c for_each(), which splits the file in chunks
+      * starting at line boundaries.
+      * \code
+      * OksSystem::LineReader reader(OksSystem::File("run.log"));
+      * std::string_view line;
+      * while(reader.next(line)) { ... }
+      * \endcode
+      * \brief Line iterator on text files
+      */
+
+    class LineReader {
+public:
+	/** How the file is read */
+	enum mode_t {
+	    AUTO,                                                     ///< \brief regular files in memory, others in blocks */
+	    MEMORY,                                                   ///< \brief the whole file in memory (mapped if large) */
+	    BLOCK                                                     ///< \brief the file read in blocks */
+	} ;
+	/** Function called for each line by the parallel iteration, with the index of the chunk of the line */
+	typedef std::function<void(std::string_view line, size_t chunk)> line_callback_t ;
+
+	static const size_t BLOCK_SIZE ;                              ///< \brief default size of the blocks read */
+	static const size_t MIN_CHUNK_SIZE ;                          ///< \brief minimum size of a chunk for parallel iteration */
+
+	static size_t for_each(const File &file, const line_callback_t &callback, unsigned int workers = 0) ; ///< \brief calls a function for each line, in parallel */
+	static size_t chunk_count(size_t size, unsigned int workers) throw() ; ///< \brief number of chunks for a parallel iteration */
+protected:
+	std::unique_ptr<FileContent> m_content ;                      ///< \brief content of the file, in memory mode */
+	std::unique_ptr<Descriptor> m_descriptor ;                    ///< \brief descriptor of the file, in block mode */
+	std::vector<char> m_buffer ;                                  ///< \brief buffer, in block mode */
+	const char *m_position ;                                      ///< \brief start of the next line */
+	const char *m_end ;                                           ///< \brief end of the data available */
+	size_t m_line_number ;                                        ///< \brief number of lines returned */
+	bool m_eof ;                                                  ///< \brief was the end of the file reached */
+	bool fill() ;                                                 ///< \brief reads the next block */
+private:
+	LineReader(const LineReader &) ;                              ///< \brief not copyable */
+	LineReader & operator=(const LineReader &) ;                  ///< \brief not assignable */
+public:
+	explicit LineReader(const File &file, mode_t mode = AUTO, size_t block_size = BLOCK_SIZE) ;
+	~LineReader() ;
+
+	bool next(std::string_view &line) ;                           ///< \brief gets the next line */
+	size_t line_number() const throw() ;                          ///< \brief number of lines returned so far */
+	bool is_in_memory() const throw() ;                           ///< \brief is the whole file in memory */
+    } ; // LineReader
+
+} // OksSystem
+
+#endif
@@ -15,14 +15,35 @@
   */
 
 #include "okssystem/File.hpp"
+#include "okssystem/FileId.hpp"
+#include "okssystem/FileStatus.hpp"
+#include "okssystem/FileSystemInfo.hpp"
+#include "okssystem/FileFingerprint.hpp"
+#include "okssystem/FingerprintCache.hpp"
+#include "okssystem/InternedPath.hpp"
+#include "okssystem/DirectoryEntry.hpp"
+#include "okssystem/DirectoryIterator.hpp"
+#include "okssystem/TreeRemover.hpp"
+#include "okssystem/TreeWalker.hpp"
+#include "okssystem/DiskUsage.hpp"
+#include "okssystem/FileCopier.hpp"
+#include "okssystem/FileContent.hpp"
+#include "okssystem/AtomicWriter.hpp"
+#include "okssystem/WorkerPool.hpp"
 #include "okssystem/Executable.hpp"
 #include "okssystem/Process.hpp"
 #include "okssystem/MapFile.hpp"
+#include "okssystem/DirectoryIndex.hpp"
 #include "okssystem/Environment.hpp"
 #include "okssystem/User.hpp"
 #include "okssystem/Host.hpp"
 #include "okssystem/Path.hpp"
 #include "okssystem/Descriptor.hpp"
+#include "okssystem/DescriptorStreamBuf.hpp"
+#include "okssystem/TemporaryFile.hpp"
+#include "okssystem/FileWatcher.hpp"
+#include "okssystem/LineReader.hpp"
+#include "okssystem/ContentHash.hpp"
 
 /** \page Sys_package The OksSystem package
   The OksSystem package contains C++ wrappers for POSIX functions and general utility classes. 
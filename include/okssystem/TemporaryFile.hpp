@@ -0,0 +1,102 @@
+/*
+ *  TemporaryFile.h
+ *  OksSystem
+ *
+ *  Temporary files created and opened in one system call.
+ *
+ */
+
+#ifndef OKSSYSTEM_TEMPORARY_FILE
+#define OKSSYSTEM_TEMPORARY_FILE
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "okssystem/Descriptor.hpp"
+
+namespace OksSystem {
+
+    class File ;
+
+    /** This class is an open temporary file.
+      * The file is created and opened by a single system call, so that there is no window
+      * between choosing a name and creating the file (which \c tempnam has).
+      * An anonymous file (\c O_TMPFILE) has no name in the directory, it vanishes when closed
+      * and can be given a name with \c link().
+      * A named file (\c mkostemp, used when a name is required or when the file system does not
+      * support \c O_TMPFILE) is removed when the object is destroyed, unless \c keep() was called.
+      * \brief Open temporary file
+      * \see OksSystem::File::make_temporary()
+      * \see OksSystem::TemporaryFilePool
+      */
+
+    class TemporaryFile {
+public:
+	static int link_descriptor(int fd, const std::string &name) throw() ; ///< \brief gives a name to an anonymous file */
+protected:
+	std::unique_ptr<Descriptor> m_descriptor ;                    ///< \brief the descriptor */
+	std::string m_directory ;                                     ///< \brief directory of the file */
+	std::string m_name ;                                          ///< \brief path of the file, empty if anonymous */
+	bool m_keep ;                                                 ///< \brief is the named file kept after destruction */
+private:
+	TemporaryFile(const TemporaryFile &) ;                        ///< \brief not copyable */
+	TemporaryFile & operator=(const TemporaryFile &) ;            ///< \brief not assignable */
+public:
+	TemporaryFile(const File &directory, const std::string &prefix, bool named = false, mode_t permissions = 0600) ;
+	TemporaryFile(TemporaryFile &&other) throw() ;
+	~TemporaryFile() ;
+
+	Descriptor & descriptor() const throw() { return *m_descriptor ; } ///< \brief the open descriptor */
+	int fd() const throw() { return m_descriptor->fd() ; }        ///< \brief the file descriptor */
+	bool is_open() const throw() { return m_descriptor!=0 ; }     ///< \brief does the object hold a file */
+	bool is_anonymous() const throw() { return m_name.empty() ; } ///< \brief has the file no name */
+	bool is_kept() const throw() { return m_keep ; }              ///< \brief is the file kept after destruction */
+	const std::string & directory() const throw() { return m_directory ; } ///< \brief directory of the file */
+	File file() const ;                                           ///< \brief the file */
+	void link(const File &name) ;                                 ///< \brief gives a (permanent) name to the file */
+	void keep() throw() ;                                         ///< \brief keeps the named file after destruction */
+	void reset() ;                                                ///< \brief empties the file for reuse */
+    } ; // TemporaryFile
+
+    /** This class keeps temporary files of a directory ready for use.
+      * Files taken from the pool are created ahead of time (\c fill()) or created on demand,
+      * files given back with \c recycle() are emptied and reused, so that a worker creating
+      * many short lived scratch files mostly avoids creating and removing directory entries.
+      * The pool is thread safe.
+      * \brief Pool of temporary files
+      * \see OksSystem::TemporaryFile
+      */
+
+    class TemporaryFilePool {
+protected:
+	std::mutex m_mutex ;                                          ///< \brief protects the files */
+	std::deque<std::unique_ptr<TemporaryFile> > m_files ;         ///< \brief files ready for use */
+	std::string m_directory ;                                     ///< \brief directory of the files */
+	std::string m_prefix ;                                        ///< \brief prefix of the names of the files */
+	size_t m_capacity ;                                           ///< \brief maximum number of files kept */
+	bool m_named ;                                                ///< \brief do the files need a name */
+	TemporaryFile *create() const ;                               ///< \brief creates a file */
+private:
+	TemporaryFilePool(const TemporaryFilePool &) ;                ///< \brief not copyable */
+	TemporaryFilePool & operator=(const TemporaryFilePool &) ;    ///< \brief not assignable */
+public:
+	static const size_t DEFAULT_CAPACITY ;                        ///< \brief default maximum number of files kept */
+
+	TemporaryFilePool(const File &directory, const std::string &prefix, size_t capacity = DEFAULT_CAPACITY, bool named = false) ;
+	~TemporaryFilePool() ;
+
+	TemporaryFile take() ;                                        ///< \brief gets a file from the pool */
+	void recycle(TemporaryFile &&file) ;                          ///< \brief gives a file back to the pool */
+	void fill(size_t count) ;                                     ///< \brief creates files ahead of time */
+	size_t size() ;                                               ///< \brief number of files ready */
+	size_t capacity() const throw() ;                             ///< \brief maximum number of files kept */
+    } ; // TemporaryFilePool
+
+} // OksSystem
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ *  TreeRemover.h
+ *  OksSystem
+ *
+ *  Parallel recursive deletion of directory trees.
+ *
+ */
+
+#ifndef OKSSYSTEM_TREE_REMOVER
+#define OKSSYSTEM_TREE_REMOVER
+
+#include <stddef.h>
+
+namespace OksSystem {
+
+    class File ;
+
+    /** This class deletes directory trees.
+      * Directories are opened relative to their parent and entries are deleted with \c unlinkat,
+      * so that no path is resolved more than once and symbolic links are never followed.
+      * Subtrees are spread over a bounded pool of worker threads.
+      * \brief Recursive file deletion
+      * \see OksSystem::File::remove_tree()
+      */
+
+    class TreeRemover {
+public:
+	/** Counters and timings of a deletion.
+	  * Times are summed over all the workers, so they can exceed the elapsed time.
+	  */
+	struct Statistics {
+	    size_t files ;                                            ///< \brief number of non directory entries removed */
+	    size_t directories ;                                      ///< \brief number of directories removed */
+	    size_t bytes ;                                            ///< \brief apparent size of the files removed */
+	    double scan_time ;                                        ///< \brief time spent reading directories (seconds) */
+	    double unlink_time ;                                      ///< \brief time spent removing files (seconds) */
+	    double rmdir_time ;                                       ///< \brief time spent removing directories (seconds) */
+	    double elapsed_time ;                                     ///< \brief wall clock time of the whole deletion (seconds) */
+	    Statistics() throw() ;
+	} ; // Statistics
+protected:
+	unsigned int m_workers ;                                      ///< \brief number of worker threads */
+public:
+	TreeRemover(unsigned int workers = 0) ;
+	Statistics remove(const File &root) const ;                   ///< \brief deletes a file or directory tree */
+    } ; // TreeRemover
+
+} // OksSystem
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ *  TreeWalker.h
+ *  OksSystem
+ *
+ *  Parallel traversal of directory trees with filters.
+ *
+ */
+
+#ifndef OKSSYSTEM_TREE_WALKER
+#define OKSSYSTEM_TREE_WALKER
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+#include "okssystem/DirectoryEntry.hpp"
+#include "okssystem/FileStatus.hpp"
+
+namespace OksSystem {
+
+    class File ;
+
+    /** This class walks directory trees, in the spirit of \c fts or \c nftw.
+      * Directories are opened relative to their parent, and subtrees are spread over a
+      * work stealing pool of threads. Symbolic links are never followed.
+      * The entries passed to the callback are selected by filters, which are checked
+      * in order of cost: depth, name, type (all without system call), then size and 
+      * modification time (one \c fstatat per entry, only if such a filter is set).
+      * Filters only select entries, all directories are descended into except those
+      * deeper than the maximum depth or matching a \c prune() pattern.
+      * \code
+      * OksSystem::TreeWalker walker;
+      * walker.name("*.data").type(OksSystem::DirectoryEntry::REGULAR).min_size(1024);
+      * walker.walk(dir,[](const OksSystem::DirectoryEntry &entry, unsigned int depth) { ... });
+      * \endcode
+      * \brief Recursive directory traversal
+      * \see OksSystem::File::find()
+      */
+
+    class TreeWalker {
+public:
+	/** Function called for each selected entry.
+	  * It is called concurrently from the worker threads, the entry is only valid during the call.
+	  * The depth of the entries directly in the root directory is 1. 
+	  */
+	typedef std::function<void(const DirectoryEntry &entry, unsigned int depth)> callback_t ;
+	/** Function called for each selected entry, with the status of the entry (symbolic links not followed) */
+	typedef std::function<void(const DirectoryEntry &entry, const FileStatus &status, unsigned int depth)> status_callback_t ;
+
+	/** Counters of a walk */
+	struct Statistics {
+	    size_t directories ;                                      ///< \brief number of directories read */
+	    size_t entries ;                                          ///< \brief number of entries seen */
+	    size_t matches ;                                          ///< \brief number of entries passed to the callback */
+	    size_t stats ;                                            ///< \brief number of \c fstatat calls for size and time filters */
+	    size_t errors ;                                           ///< \brief number of directories that could not be read */
+	    double elapsed_time ;                                     ///< \brief wall clock time of the walk (seconds) */
+	    Statistics() throw() ;
+	} ; // Statistics
+protected:
+	unsigned int m_workers ;                                      ///< \brief number of worker threads */
+	Statistics walk(const File &root, const callback_t *callback, const status_callback_t *status_callback) const ; ///< \brief walks a tree */
+	std::vector<std::string> m_names ;                            ///< \brief glob patterns for names (any matches) */
+	std::vector<std::string> m_prune ;                            ///< \brief glob patterns for directories not descended */
+	unsigned int m_types ;                                        ///< \brief mask of accepted types (bit \c 1<<type), 0 for any */
+	unsigned int m_max_depth ;                                    ///< \brief maximum depth of entries */
+	size_t m_min_size ;                                           ///< \brief minimum size */
+	size_t m_max_size ;                                           ///< \brief maximum size */
+	time_t m_modified_after ;                                     ///< \brief minimum modification time */
+	time_t m_modified_before ;                                    ///< \brief maximum modification time */
+	bool m_ignore_errors ;                                        ///< \brief skip unreadable directories silently */
+public:
+	TreeWalker(unsigned int workers = 0) ;
+
+	TreeWalker & name(const std::string &pattern) ;               ///< \brief selects entries whose name matches a glob pattern */
+	TreeWalker & prune(const std::string &pattern) ;              ///< \brief does not descend into directories matching a glob pattern */
+	TreeWalker & type(DirectoryEntry::type_t type) ;              ///< \brief selects entries of a given type */
+	TreeWalker & max_depth(unsigned int depth) ;                  ///< \brief limits the depth of the walk */
+	TreeWalker & min_size(size_t size) ;                          ///< \brief selects entries at least that large */
+	TreeWalker & max_size(size_t size) ;                          ///< \brief selects entries at most that large */
+	TreeWalker & modified_after(time_t time) ;                    ///< \brief selects entries modified at or after a time */
+	TreeWalker & modified_before(time_t time) ;                   ///< \brief selects entries modified before a time */
+	TreeWalker & ignore_errors(bool ignore) ;                     ///< \brief continues silently on unreadable directories */
+
+	bool accepts_name(const char *name) const throw() ;           ///< \brief checks the name filters */
+	bool accepts_type(DirectoryEntry::type_t type) const throw() ; ///< \brief checks the type filter */
+	bool prunes(const char *name) const throw() ;                 ///< \brief checks the prune patterns */
+	bool accepts_status(const FileStatus &status) const throw() ; ///< \brief checks the size and time filters */
+	bool needs_status() const throw() ;                           ///< \brief are there size or time filters */
+	bool ignores_errors() const throw() ;                         ///< \brief are unreadable directories skipped silently */
+
+	Statistics walk(const File &root, const callback_t &callback) const ; ///< \brief walks a tree */
+	Statistics walk(const File &root, const status_callback_t &callback) const ; ///< \brief walks a tree, with the status of entries */
+	std::vector<DirectoryEntry> find(const File &root) const ;     ///< \brief collects the selected entries of a tree */
+    } ; // TreeWalker
+
+} // OksSystem
+
+#endif
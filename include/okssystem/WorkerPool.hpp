@@ -0,0 +1,71 @@
+/*
+ *  WorkerPool.h
+ *  OksSystem
+ *
+ *  Bounded pool of threads executing tasks.
+ *
+ */
+
+#ifndef OKSSYSTEM_WORKER_POOL
+#define OKSSYSTEM_WORKER_POOL
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OksSystem {
+
+    /** This class represents a fixed size pool of worker threads.
+      * Tasks can be submitted from any thread, including from tasks running in the pool,
+      * which makes it suitable for recursive work like walking directory trees.
+      * \c wait() returns once all submitted tasks, and the tasks they submitted, are finished.
+      * If a task throws, the first exception is kept and rethrown by \c wait().
+      * Each worker has its own queue, idle workers steal work from the other queues (see \c submit()).
+      * \brief Thread pool
+      */
+
+    class WorkerPool {
+public:
+	typedef std::function<void()> task_t ;
+protected:
+	/** Queue of tasks of one worker */
+	struct Queue {
+	    std::mutex m_mutex ;                                      ///< \brief protects the tasks */
+	    std::deque<task_t> m_tasks ;                              ///< \brief tasks not yet started */
+	} ; // Queue
+	std::vector<std::thread> m_threads ;                          ///< \brief worker threads */
+	std::vector<std::unique_ptr<Queue> > m_queues ;               ///< \brief one queue per worker */
+	std::atomic<size_t> m_next_queue ;                            ///< \brief queue for the next task submitted from outside */
+	std::mutex m_mutex ;                                          ///< \brief protects the counters */
+	std::condition_variable m_work ;                              ///< \brief signaled when a task is queued */
+	std::condition_variable m_idle ;                              ///< \brief signaled when the pool becomes idle */
+	size_t m_queued ;                                             ///< \brief number of tasks in the queues */
+	size_t m_active ;                                             ///< \brief number of tasks running */
+	bool m_stop ;                                                 ///< \brief are the workers asked to stop */
+	std::exception_ptr m_error ;                                  ///< \brief first exception thrown by a task */
+	bool take(size_t index, task_t &task) ;                       ///< \brief takes a task from the own queue or steals one */
+	void run(size_t index) ;                                      ///< \brief main loop of worker threads */
+private:
+	WorkerPool(const WorkerPool &) ;                              ///< \brief not copyable */
+	WorkerPool & operator=(const WorkerPool &) ;                  ///< \brief not assignable */
+public:
+	static unsigned int default_size() throw() ;                  ///< \brief number of hardware threads */
+
+	WorkerPool(unsigned int workers = 0) ;
+	~WorkerPool() ;
+
+	void submit(const task_t &task) ;                             ///< \brief queues a task */
+	void wait() ;                                                 ///< \brief waits for all tasks to be done */
+	size_t pending() ;                                            ///< \brief number of tasks not yet started */
+	unsigned int size() const throw() ;                           ///< \brief number of worker threads */
+    } ; // WorkerPool
+
+} // OksSystem
+
+#endif
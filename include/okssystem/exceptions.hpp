@@ -134,6 +134,16 @@ ERS_DECLARE_ISSUE_BASE(	OksSystem, // namespace
                         ((const char *)dest ) // single attribute
                  )
 
+ERS_DECLARE_ISSUE_BASE(	OksSystem, // namespace
+			NoSpaceIssue, // issue class name
+                        PosixIssue, // base class name
+                        "Not enough space for file \"" << name << "\": " << needed << " bytes needed, " << available << " available", // message
+                        ((int)error ), // base class attribute
+                        ((const char *)name ) // first attribute
+                        ((unsigned long)needed ) // second attribute
+                        ((unsigned long)available ) // third attribute
+                 )
+
 #define OKSSYSTEM_ALLOC_CHECK( p, size ) \
 { if(0==p) throw OksSystem::AllocIssue( ERS_HERE, errno, size ); }
 
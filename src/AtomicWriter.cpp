@@ -0,0 +1,298 @@
+/*
+ *  AtomicWriter.cxx
+ *  OksSystem
+ *
+ *  Atomic and durable replacement of the content of a file.
+ *
+ */
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "ers/ers.hpp"
+#include "ers/Assertion.hpp"
+
+#include "okssystem/AtomicWriter.hpp"
+#include "okssystem/TemporaryFile.hpp"
+#include "okssystem/File.hpp"
+#include "okssystem/exceptions.hpp"
+
+namespace {
+
+    /** Counter making the names of the temporary files unique in the process */
+    std::atomic<unsigned long> s_temporary_count(0);
+
+    /** Number of attempts to find a free temporary name */
+    const int NAME_ATTEMPTS = 16;
+
+    /** Reads the umask of the process.
+      * The kernel reports it in \c /proc/self/status, otherwise it is read by setting it temporarily,
+      * which is only safe against other callers of this function.
+      * \return the umask
+      */
+    mode_t current_umask() {
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while(std::getline(status,line)) {
+	    if (0==line.compare(0,6,"Umask:")) {
+		return (mode_t) std::stoul(line.substr(6),0,8);
+	    } // if
+	} // while
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+	const mode_t mask = ::umask(022);
+	::umask(mask);
+	return mask;
+    } // current_umask
+
+} // anonymous namespace
+
+OksSystem::AtomicWriter::SyncBatch::SyncBatch() {
+} // SyncBatch
+
+/** Destructor, flushes the directories not flushed yet, errors are reported as warnings */
+
+OksSystem::AtomicWriter::SyncBatch::~SyncBatch() {
+    try {
+	sync();
+    } catch (ers::Issue &ex) {
+	ers::warning(ex);
+    } // catch
+} // ~SyncBatch
+
+void OksSystem::AtomicWriter::SyncBatch::add(const std::string &directory) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_directories.insert(directory);
+} // add
+
+size_t OksSystem::AtomicWriter::SyncBatch::size() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_directories.size();
+} // size
+
+/** Flushes each registered directory once.
+  * All the directories are flushed even if one fails.
+  * \exception OksSystem::OksSystemCallIssue if a directory cannot be flushed (the first error)
+  */
+
+void OksSystem::AtomicWriter::SyncBatch::sync() {
+    std::set<std::string> directories;
+    {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	directories.swap(m_directories);
+    }
+    std::exception_ptr error;
+    for(std::set<std::string>::const_iterator pos=directories.begin();pos!=directories.end();++pos) {
+	try {
+	    sync_directory(*pos);
+	} catch (ers::Issue &) {
+	    if (! error) error = std::current_exception();
+	} // catch
+    } // for
+    if (error) std::rethrow_exception(error);
+} // sync
+
+/** Flushes a directory, so that the creation, removal or renaming of entries is durable.
+  * \param directory path of the directory
+  * \exception OksSystem::OpenFileIssue if the directory cannot be opened
+  * \exception OksSystem::OksSystemCallIssue if the flush fails
+  */
+
+void OksSystem::AtomicWriter::sync_directory(const std::string &directory) {
+    const int fd = ::open(directory.c_str(),O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd<0) {
+	throw OksSystem::OpenFileIssue( ERS_HERE, errno, directory.c_str() );
+    } // if
+    if (0!=::fsync(fd)) {
+	const int error = errno;
+	::close(fd);
+	std::string message = "on directory " + directory;
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, error, "fsync", message.c_str() );
+    } // if
+    ::close(fd);
+} // sync_directory
+
+/** Creates the temporary file that receives the new content.
+  * Explicit permissions are applied exactly (they are not masked by the umask).
+  * By default the new file keeps the permissions of the target, so that replacing a private file does not expose it,
+  * or gets the permissions of a newly created file (\c 0666 masked by the umask) if the target does not exist.
+  * \param target the file to replace, its directory must exist
+  * \param permissions permissions of the new file, or \c KEEP_PERMISSIONS
+  * \param batch if not null, the flush of the directory is deferred to this batch
+  * \exception OksSystem::OpenFileIssue if the temporary file cannot be created
+  */
+
+OksSystem::AtomicWriter::AtomicWriter(const File &target, mode_t permissions, SyncBatch *batch) {
+    m_target = target.full_name();
+    m_directory = target.parent_name();
+    m_batch = batch;
+    m_size = 0;
+    m_fd = -1;
+    open(permissions);
+} // AtomicWriter
+
+/** Move constructor, the other writer is left closed */
+
+OksSystem::AtomicWriter::AtomicWriter(AtomicWriter &&other) throw() : m_target(std::move(other.m_target)), m_directory(std::move(other.m_directory)), m_temporary(std::move(other.m_temporary)) {
+    m_batch = other.m_batch;
+    m_size = other.m_size;
+    m_fd = other.m_fd;
+    other.m_temporary.clear();
+    other.m_fd = -1;
+} // AtomicWriter
+
+/** Destructor, the new content is dropped if it was not committed */
+
+OksSystem::AtomicWriter::~AtomicWriter() {
+    discard();
+} // ~AtomicWriter
+
+/** Finds the permissions the new content gets by default.
+  * \return the permissions of the target if it exists, otherwise \c 0666 masked by the umask
+  */
+
+mode_t OksSystem::AtomicWriter::target_permissions() const {
+    struct stat status;
+    if (0==::stat(m_target.c_str(),&status)) {
+	return status.st_mode & 07777;
+    } // if
+    return 0666 & ~current_umask();
+} // target_permissions
+
+/** Opens an anonymous file in the directory of the target,
+  * or a hidden temporary file if the file system does not support \c O_TMPFILE.
+  */
+
+void OksSystem::AtomicWriter::open(mode_t permissions) {
+    if (KEEP_PERMISSIONS==permissions) {
+	permissions = target_permissions();
+    } // if
+    m_fd = ::open(m_directory.c_str(),O_TMPFILE | O_WRONLY | O_CLOEXEC,permissions);
+    if (m_fd<0 && (EOPNOTSUPP==errno || EISDIR==errno || EINVAL==errno)) {
+	std::string name = m_directory + "/." + File::short_name(m_target) + ".XXXXXX";
+	m_fd = ::mkostemp(&name[0],O_CLOEXEC);
+	if (m_fd>=0) m_temporary = name;
+    } // if
+    if (m_fd<0) {
+	throw OksSystem::OpenFileIssue( ERS_HERE, errno, m_target.c_str() );
+    } // if
+    if (0!=::fchmod(m_fd,permissions)) {
+	const int error = errno;
+	discard();
+	std::string message = "on file " + m_target;
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, error, "fchmod", message.c_str() );
+    } // if
+} // open
+
+/** Gives a name to the anonymous file.
+  * \param name the name to give
+  * \return 0 on success, or the error code
+  */
+
+int OksSystem::AtomicWriter::link(const std::string &name) throw() {
+    return TemporaryFile::link_descriptor(m_fd,name);
+} // link
+
+/** Closes and removes the temporary file, an anonymous file simply vanishes when closed */
+
+void OksSystem::AtomicWriter::discard() throw() {
+    if (m_fd>=0) {
+	::close(m_fd);
+	m_fd = -1;
+    } // if
+    if (! m_temporary.empty()) {
+	::unlink(m_temporary.c_str());
+	m_temporary.clear();
+    } // if
+} // discard
+
+/** Appends data to the new content.
+  * \param data start of the data
+  * \param size number of bytes
+  * \exception OksSystem::WriteIssue if the data cannot be written, the writer is then closed
+  */
+
+void OksSystem::AtomicWriter::write(const void *data, size_t size) {
+    ERS_PRECONDITION(m_fd>=0);
+    const char *bytes = (const char *) data;
+    while(size>0) {
+	const ssize_t n = ::write(m_fd,bytes,size);
+	if (n<0) {
+	    if (EINTR==errno) continue;
+	    const int error = errno;
+	    discard();
+	    throw OksSystem::WriteIssue( ERS_HERE, error, m_target.c_str() );
+	} // if
+	bytes += n;
+	size -= n;
+	m_size += n;
+    } // while
+} // write
+
+void OksSystem::AtomicWriter::write(std::string_view data) {
+    write(data.data(),data.size());
+} // write
+
+/** Replaces the target with the new content.
+  * The data is flushed, the file is given a temporary name if it is anonymous,
+  * and renamed over the target. Finally the directory is flushed, or registered in the batch.
+  * The writer is closed in all cases. If the data cannot be flushed, linked or renamed, the target is left untouched.
+  * Once the rename succeeded the target holds the new content, even if closing the file or flushing the directory
+  * fails afterwards: the exception then only means that the replacement may not survive a crash.
+  * \exception OksSystem::OksSystemCallIssue if the data cannot be flushed or the file cannot be linked (target untouched),
+  * or if the directory cannot be flushed (target replaced)
+  * \exception OksSystem::RenameFileIssue if the target cannot be replaced (target untouched)
+  * \exception OksSystem::CloseFileIssue if the new file cannot be closed (target replaced)
+  */
+
+void OksSystem::AtomicWriter::commit() {
+    ERS_PRECONDITION(m_fd>=0);
+    if (0!=::fdatasync(m_fd)) {
+	const int error = errno;
+	discard();
+	std::string message = "on file " + m_target;
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, error, "fdatasync", message.c_str() );
+    } // if
+    for(int i=0;m_temporary.empty();i++) {
+	const std::string name = m_directory + "/." + File::short_name(m_target) + "." + std::to_string(::getpid())
+	    + "." + std::to_string(s_temporary_count++);
+	const int error = link(name);
+	if (0==error) {
+	    m_temporary = name;
+	} else if (EEXIST!=error || i+1>=NAME_ATTEMPTS) {
+	    discard();
+	    std::string message = "on file " + name;
+	    throw OksSystem::OksSystemCallIssue( ERS_HERE, error, "linkat", message.c_str() );
+	} // if
+    } // for
+    if (0!=::rename(m_temporary.c_str(),m_target.c_str())) {
+	const int error = errno;
+	const std::string temporary = m_temporary;
+	discard();
+	throw OksSystem::RenameFileIssue( ERS_HERE, error, temporary.c_str(), m_target.c_str() );
+    } // if
+    m_temporary.clear();
+    const int status = ::close(m_fd);
+    m_fd = -1;
+    if (status<0) {
+	throw OksSystem::CloseFileIssue( ERS_HERE, errno, m_target.c_str() );
+    } // if
+    if (m_batch) {
+	m_batch->add(m_directory);
+    } else {
+	sync_directory(m_directory);
+    } // if
+} // commit
+
+/** Drops the new content, the target is left untouched */
+
+void OksSystem::AtomicWriter::abort() throw() {
+    discard();
+} // abort
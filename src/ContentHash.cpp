@@ -0,0 +1,765 @@
+/*
+ *  ContentHash.cxx
+ *  OksSystem
+ *
+ *  Hashing of the content of files, in parallel.
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "okssystem/ContentHash.hpp"
+#include "okssystem/File.hpp"
+#include "okssystem/WorkerPool.hpp"
+#include "okssystem/exceptions.hpp"
+
+const size_t OksSystem::ContentHash::CHUNK_SIZE = 16*1024*1024;
+const size_t OksSystem::ContentHash::BUFFER_SIZE = 1024*1024;
+
+namespace {
+
+    /** Incremental hash function */
+    class Hasher {
+    public:
+	virtual ~Hasher() {}
+	virtual void update(const unsigned char *data, size_t size) = 0 ;
+	virtual std::string digest() = 0 ;                        ///< raw (binary) digest */
+    } ; // Hasher
+
+    inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64-r)); }
+    inline uint32_t rotr32(uint32_t x, int r) { return (x >> r) | (x << (32-r)); }
+    inline uint64_t read64(const unsigned char *p) { uint64_t v; memcpy(&v,p,8); return v; } // little endian platforms
+    inline uint32_t read32(const unsigned char *p) { uint32_t v; memcpy(&v,p,4); return v; }
+
+    /** XXH64 with seed 0, following the reference specification of xxHash */
+    class Xxh64Hasher : public Hasher {
+	static const uint64_t P1 = 11400714785074694791ULL;
+	static const uint64_t P2 = 14029467366897019727ULL;
+	static const uint64_t P3 = 1609587929392839161ULL;
+	static const uint64_t P4 = 9650029242287828579ULL;
+	static const uint64_t P5 = 2870177450012600261ULL;
+	uint64_t m_v[4];
+	uint64_t m_total;
+	unsigned char m_memory[32];
+	size_t m_memory_size;
+	static uint64_t round(uint64_t acc, uint64_t input) {
+	    acc += input*P2;
+	    return rotl64(acc,31)*P1;
+	} // round
+	static uint64_t merge(uint64_t acc, uint64_t value) {
+	    acc ^= round(0,value);
+	    return acc*P1+P4;
+	} // merge
+	void stripe(const unsigned char *p) {
+	    m_v[0] = round(m_v[0],read64(p));
+	    m_v[1] = round(m_v[1],read64(p+8));
+	    m_v[2] = round(m_v[2],read64(p+16));
+	    m_v[3] = round(m_v[3],read64(p+24));
+	} // stripe
+    public:
+	Xxh64Hasher() {
+	    m_v[0] = P1+P2;
+	    m_v[1] = P2;
+	    m_v[2] = 0;
+	    m_v[3] = 0-P1;
+	    m_total = 0;
+	    m_memory_size = 0;
+	} // Xxh64Hasher
+	void update(const unsigned char *data, size_t size) {
+	    m_total += size;
+	    if (m_memory_size+size<32) {
+		memcpy(m_memory+m_memory_size,data,size);
+		m_memory_size += size;
+		return;
+	    } // if
+	    const unsigned char *end = data+size;
+	    if (m_memory_size>0) {
+		memcpy(m_memory+m_memory_size,data,32-m_memory_size);
+		data += 32-m_memory_size;
+		stripe(m_memory);
+		m_memory_size = 0;
+	    } // if
+	    for(;data+32<=end;data+=32) stripe(data);
+	    m_memory_size = end-data;
+	    memcpy(m_memory,data,m_memory_size);
+	} // update
+	uint64_t value() const {
+	    uint64_t h;
+	    if (m_total>=32) {
+		h = rotl64(m_v[0],1) + rotl64(m_v[1],7) + rotl64(m_v[2],12) + rotl64(m_v[3],18);
+		for(int i=0;i<4;i++) h = merge(h,m_v[i]);
+	    } else {
+		h = P5;
+	    } // if
+	    h += m_total;
+	    const unsigned char *p = m_memory;
+	    const unsigned char *end = m_memory+m_memory_size;
+	    for(;p+8<=end;p+=8) {
+		h ^= round(0,read64(p));
+		h = rotl64(h,27)*P1+P4;
+	    } // for
+	    if (p+4<=end) {
+		h ^= (uint64_t) read32(p)*P1;
+		h = rotl64(h,23)*P2+P3;
+		p += 4;
+	    } // if
+	    for(;p<end;p++) {
+		h ^= (*p)*P5;
+		h = rotl64(h,11)*P1;
+	    } // for
+	    h ^= h >> 33;
+	    h *= P2;
+	    h ^= h >> 29;
+	    h *= P3;
+	    h ^= h >> 32;
+	    return h;
+	} // value
+	std::string digest() {
+	    const uint64_t h = value();
+	    std::string raw(8,'\0');
+	    for(int i=0;i<8;i++) raw[i] = (char) (h >> (56-8*i)); // canonical (big endian) form
+	    return raw;
+	} // digest
+    } ; // Xxh64Hasher
+
+    /** XXH3 128 bits with seed 0 and the default secret, following the reference implementation of xxHash.
+      * The input is accumulated in stripes of 64 bytes, the last ones are kept in a buffer 
+      * so that short inputs (up to 240 bytes) can be hashed with their dedicated functions.
+      */
+    class Xxh3Hasher : public Hasher {
+	static const uint64_t P64_1 = 0x9E3779B185EBCA87ULL;
+	static const uint64_t P64_2 = 0xC2B2AE3D27D4EB4FULL;
+	static const uint64_t P64_3 = 0x165667B19E3779F9ULL;
+	static const uint64_t P64_4 = 0x85EBCA77C2B2AE63ULL;
+	static const uint64_t P64_5 = 0x27D4EB2F165667C5ULL;
+	static const uint32_t P32_1 = 0x9E3779B1U;
+	static const uint32_t P32_2 = 0x85EBCA77U;
+	static const uint32_t P32_3 = 0xC2B2AE3DU;
+	static const size_t STRIPE_SIZE = 64;
+	static const size_t SECRET_SIZE = 192;
+	static const size_t BUFFER_SIZE = 256;
+	static const size_t STRIPES_PER_BLOCK = (SECRET_SIZE-STRIPE_SIZE)/8;
+	static const size_t MID_SIZE_MAX = 240;
+	static const unsigned char SECRET[SECRET_SIZE];
+	uint64_t m_acc[8];
+	unsigned char m_buffer[BUFFER_SIZE];
+	size_t m_buffer_size;
+	size_t m_stripes;                                         // stripes accumulated in the current block
+	uint64_t m_total;
+
+	static void multiply(uint64_t a, uint64_t b, uint64_t &low, uint64_t &high) {
+	    const unsigned __int128 product = (unsigned __int128) a * b;
+	    low = (uint64_t) product;
+	    high = (uint64_t) (product >> 64);
+	} // multiply
+	static uint64_t fold(uint64_t a, uint64_t b) {
+	    uint64_t low, high;
+	    multiply(a,b,low,high);
+	    return low ^ high;
+	} // fold
+	static uint64_t xxh64_avalanche(uint64_t h) {
+	    h ^= h >> 33;
+	    h *= P64_2;
+	    h ^= h >> 29;
+	    h *= P64_3;
+	    return h ^ (h >> 32);
+	} // xxh64_avalanche
+	static uint64_t avalanche(uint64_t h) {
+	    h ^= h >> 37;
+	    h *= 0x165667919E3779F9ULL;
+	    return h ^ (h >> 32);
+	} // avalanche
+	static uint64_t mix16(const unsigned char *input, const unsigned char *secret) {
+	    return fold(read64(input) ^ read64(secret),read64(input+8) ^ read64(secret+8));
+	} // mix16
+	static void mix32(uint64_t &low, uint64_t &high, const unsigned char *input1, const unsigned char *input2, const unsigned char *secret) {
+	    low += mix16(input1,secret);
+	    low ^= read64(input2) + read64(input2+8);
+	    high += mix16(input2,secret+16);
+	    high ^= read64(input1) + read64(input1+8);
+	} // mix32
+	static void accumulate_stripe(uint64_t *acc, const unsigned char *input, const unsigned char *secret) {
+	    for(int i=0;i<8;i++) {
+		const uint64_t value = read64(input+8*i);
+		const uint64_t key = value ^ read64(secret+8*i);
+		acc[i ^ 1] += value;
+		acc[i] += (key & 0xFFFFFFFFULL) * (key >> 32);
+	    } // for
+	} // accumulate_stripe
+	static void scramble(uint64_t *acc, const unsigned char *secret) {
+	    for(int i=0;i<8;i++) {
+		uint64_t a = acc[i];
+		a ^= a >> 47;
+		a ^= read64(secret+8*i);
+		acc[i] = a * P32_1;
+	    } // for
+	} // scramble
+	static void accumulate(uint64_t *acc, const unsigned char *input, const unsigned char *secret, size_t stripes) {
+	    for(size_t i=0;i<stripes;i++) accumulate_stripe(acc,input+i*STRIPE_SIZE,secret+i*8);
+	} // accumulate
+	/** Accumulates stripes, scrambling at the end of each block \return the stripes in the current block */
+	static size_t consume(uint64_t *acc, size_t stripes, size_t accumulated, const unsigned char *input) {
+	    if (STRIPES_PER_BLOCK-accumulated<=stripes) {
+		const size_t to_end = STRIPES_PER_BLOCK-accumulated;
+		accumulate(acc,input,SECRET+accumulated*8,to_end);
+		scramble(acc,SECRET+SECRET_SIZE-STRIPE_SIZE);
+		accumulate(acc,input+to_end*STRIPE_SIZE,SECRET,stripes-to_end);
+		return stripes-to_end;
+	    } // if
+	    accumulate(acc,input,SECRET+accumulated*8,stripes);
+	    return accumulated+stripes;
+	} // consume
+	static uint64_t merge(const uint64_t *acc, const unsigned char *secret, uint64_t start) {
+	    for(int i=0;i<4;i++) start += fold(acc[2*i] ^ read64(secret+16*i),acc[2*i+1] ^ read64(secret+16*i+8));
+	    return avalanche(start);
+	} // merge
+	/** Hashes an input of at most \c MID_SIZE_MAX bytes */
+	static void hash_short(const unsigned char *p, size_t length, uint64_t &low, uint64_t &high) {
+	    const unsigned char *s = SECRET;
+	    if (0==length) {
+		low = xxh64_avalanche(read64(s+64) ^ read64(s+72));
+		high = xxh64_avalanche(read64(s+80) ^ read64(s+88));
+	    } else if (length<=3) {
+		const uint32_t combined = ((uint32_t) p[0] << 16) | ((uint32_t) p[length>>1] << 24) | p[length-1] | ((uint32_t) length << 8);
+		const uint32_t swapped = __builtin_bswap32(combined);
+		const uint32_t rotated = (swapped << 13) | (swapped >> 19);
+		low = xxh64_avalanche(combined ^ (uint64_t) (read32(s) ^ read32(s+4)));
+		high = xxh64_avalanche(rotated ^ (uint64_t) (read32(s+8) ^ read32(s+12)));
+	    } else if (length<=8) {
+		const uint64_t input = read32(p) + ((uint64_t) read32(p+length-4) << 32);
+		uint64_t l, h;
+		multiply(input ^ read64(s+16) ^ read64(s+24),P64_1+(length << 2),l,h);
+		h += l << 1;
+		l ^= h >> 3;
+		l ^= l >> 35;
+		l *= 0x9FB21C651E98DF25ULL;
+		low = l ^ (l >> 28);
+		high = avalanche(h);
+	    } else if (length<=16) {
+		const uint64_t flip_low = read64(s+32) ^ read64(s+40);
+		const uint64_t flip_high = read64(s+48) ^ read64(s+56);
+		const uint64_t input_low = read64(p);
+		uint64_t input_high = read64(p+length-8);
+		uint64_t l, h;
+		multiply(input_low ^ input_high ^ flip_low,P64_1,l,h);
+		l += (uint64_t) (length-1) << 54;
+		input_high ^= flip_high;
+		h += input_high + (uint64_t) (uint32_t) input_high * (P32_2-1);
+		l ^= __builtin_bswap64(h);
+		uint64_t result_low, result_high;
+		multiply(l,P64_2,result_low,result_high);
+		result_high += h*P64_2;
+		low = avalanche(result_low);
+		high = avalanche(result_high);
+	    } else {
+		uint64_t l = length*P64_1;
+		uint64_t h = 0;
+		if (length<=128) {
+		    if (length>32) {
+			if (length>64) {
+			    if (length>96) mix32(l,h,p+48,p+length-64,s+96);
+			    mix32(l,h,p+32,p+length-48,s+64);
+			} // if
+			mix32(l,h,p+16,p+length-32,s+32);
+		    } // if
+		    mix32(l,h,p,p+length-16,s);
+		} else {
+		    const size_t rounds = length/32;
+		    for(size_t i=0;i<4;i++) mix32(l,h,p+32*i,p+32*i+16,s+32*i);
+		    l = avalanche(l);
+		    h = avalanche(h);
+		    for(size_t i=4;i<rounds;i++) mix32(l,h,p+32*i,p+32*i+16,s+3+32*(i-4));
+		    mix32(l,h,p+length-16,p+length-32,s+136-17-16);
+		} // if
+		low = avalanche(l+h);
+		high = 0-avalanche(l*P64_1 + h*P64_4 + length*P64_2);
+	    } // if
+	} // hash_short
+    public:
+	Xxh3Hasher() {
+	    const uint64_t initial[8] = { P32_3, P64_1, P64_2, P64_3, P64_4, P32_2, P64_5, P32_1 };
+	    memcpy(m_acc,initial,sizeof(m_acc));
+	    m_buffer_size = 0;
+	    m_stripes = 0;
+	    m_total = 0;
+	} // Xxh3Hasher
+	void update(const unsigned char *data, size_t size) {
+	    m_total += size;
+	    if (m_buffer_size+size<=BUFFER_SIZE) {
+		memcpy(m_buffer+m_buffer_size,data,size);
+		m_buffer_size += size;
+		return;
+	    } // if
+	    if (m_buffer_size>0) {
+		const size_t fill = BUFFER_SIZE-m_buffer_size;
+		memcpy(m_buffer+m_buffer_size,data,fill);
+		data += fill;
+		size -= fill;
+		m_stripes = consume(m_acc,BUFFER_SIZE/STRIPE_SIZE,m_stripes,m_buffer);
+		m_buffer_size = 0;
+	    } // if
+	    if (size>BUFFER_SIZE) {
+		do {
+		    m_stripes = consume(m_acc,BUFFER_SIZE/STRIPE_SIZE,m_stripes,data);
+		    data += BUFFER_SIZE;
+		    size -= BUFFER_SIZE;
+		} while(size>BUFFER_SIZE);
+		memcpy(m_buffer+BUFFER_SIZE-STRIPE_SIZE,data-STRIPE_SIZE,STRIPE_SIZE); // last stripe, for short ends
+	    } // if
+	    memcpy(m_buffer,data,size);
+	    m_buffer_size = size;
+	} // update
+	std::string digest() {
+	    uint64_t low, high;
+	    if (m_total<=MID_SIZE_MAX) {
+		hash_short(m_buffer,m_total,low,high);
+	    } else {
+		uint64_t acc[8];
+		memcpy(acc,m_acc,sizeof(acc));
+		const unsigned char *last_secret = SECRET+SECRET_SIZE-STRIPE_SIZE-7;
+		if (m_buffer_size>=STRIPE_SIZE) {
+		    consume(acc,(m_buffer_size-1)/STRIPE_SIZE,m_stripes,m_buffer);
+		    accumulate_stripe(acc,m_buffer+m_buffer_size-STRIPE_SIZE,last_secret);
+		} else {
+		    unsigned char last[STRIPE_SIZE];
+		    const size_t catch_up = STRIPE_SIZE-m_buffer_size;
+		    memcpy(last,m_buffer+BUFFER_SIZE-catch_up,catch_up);
+		    memcpy(last+catch_up,m_buffer,m_buffer_size);
+		    accumulate_stripe(acc,last,last_secret);
+		} // if
+		low = merge(acc,SECRET+11,m_total*P64_1);
+		high = merge(acc,SECRET+SECRET_SIZE-sizeof(acc)-11,~(m_total*P64_2));
+	    } // if
+	    std::string raw(16,'\0');
+	    for(int i=0;i<8;i++) {
+		raw[i] = (char) (high >> (56-8*i)); // canonical (big endian) form
+		raw[8+i] = (char) (low >> (56-8*i));
+	    } // for
+	    return raw;
+	} // digest
+    } ; // Xxh3Hasher
+
+    const unsigned char Xxh3Hasher::SECRET[Xxh3Hasher::SECRET_SIZE] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+    } ;
+
+    /** SHA-256 as specified in FIPS 180-4 */
+    class Sha256Hasher : public Hasher {
+	static const uint32_t K[64];
+	uint32_t m_h[8];
+	uint64_t m_total;
+	unsigned char m_block[64];
+	size_t m_block_size;
+	void compress(const unsigned char *p) {
+	    uint32_t w[64];
+	    for(int i=0;i<16;i++) {
+		w[i] = ((uint32_t) p[4*i] << 24) | ((uint32_t) p[4*i+1] << 16) | ((uint32_t) p[4*i+2] << 8) | p[4*i+3];
+	    } // for
+	    for(int i=16;i<64;i++) {
+		const uint32_t s0 = rotr32(w[i-15],7) ^ rotr32(w[i-15],18) ^ (w[i-15] >> 3);
+		const uint32_t s1 = rotr32(w[i-2],17) ^ rotr32(w[i-2],19) ^ (w[i-2] >> 10);
+		w[i] = w[i-16] + s0 + w[i-7] + s1;
+	    } // for
+	    uint32_t a = m_h[0], b = m_h[1], c = m_h[2], d = m_h[3], e = m_h[4], f = m_h[5], g = m_h[6], h = m_h[7];
+	    for(int i=0;i<64;i++) {
+		const uint32_t t1 = h + (rotr32(e,6) ^ rotr32(e,11) ^ rotr32(e,25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+		const uint32_t t2 = (rotr32(a,2) ^ rotr32(a,13) ^ rotr32(a,22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g; g = f; f = e; e = d + t1;
+		d = c; c = b; b = a; a = t1 + t2;
+	    } // for
+	    m_h[0] += a; m_h[1] += b; m_h[2] += c; m_h[3] += d;
+	    m_h[4] += e; m_h[5] += f; m_h[6] += g; m_h[7] += h;
+	} // compress
+    public:
+	Sha256Hasher() {
+	    static const uint32_t initial[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+	    memcpy(m_h,initial,sizeof(m_h));
+	    m_total = 0;
+	    m_block_size = 0;
+	} // Sha256Hasher
+	void update(const unsigned char *data, size_t size) {
+	    m_total += size;
+	    if (m_block_size>0) {
+		const size_t n = (size<64-m_block_size) ? size : 64-m_block_size;
+		memcpy(m_block+m_block_size,data,n);
+		m_block_size += n;
+		data += n;
+		size -= n;
+		if (m_block_size<64) return;
+		compress(m_block);
+		m_block_size = 0;
+	    } // if
+	    for(;size>=64;data+=64,size-=64) compress(data);
+	    memcpy(m_block,data,size);
+	    m_block_size = size;
+	} // update
+	std::string digest() {
+	    const uint64_t bits = m_total*8;
+	    unsigned char padding[72] = { 0x80 };
+	    const size_t pad = (m_block_size<56) ? 56-m_block_size : 120-m_block_size;
+	    for(int i=0;i<8;i++) padding[pad+i] = (unsigned char) (bits >> (56-8*i));
+	    const uint64_t total = m_total;
+	    update(padding,pad+8);
+	    m_total = total;
+	    std::string raw(32,'\0');
+	    for(int i=0;i<32;i++) raw[i] = (char) (m_h[i/4] >> (24-8*(i%4)));
+	    return raw;
+	} // digest
+    } ; // Sha256Hasher
+
+    const uint32_t Sha256Hasher::K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    } ;
+
+    std::unique_ptr<Hasher> make_hasher(OksSystem::ContentHash::algorithm_t algorithm) {
+	switch(algorithm) {
+	    case OksSystem::ContentHash::SHA256:
+	    case OksSystem::ContentHash::SHA256_TREE: return std::unique_ptr<Hasher>(new Sha256Hasher());
+	    case OksSystem::ContentHash::XXH128:
+	    case OksSystem::ContentHash::XXH128_TREE: return std::unique_ptr<Hasher>(new Xxh3Hasher());
+	    default: break;
+	} // switch
+	return std::unique_ptr<Hasher>(new Xxh64Hasher());
+    } // make_hasher
+
+    std::string to_hex(const std::string &raw) {
+	static const char digits[] = "0123456789abcdef";
+	std::string hex(2*raw.size(),'0');
+	for(size_t i=0;i<raw.size();i++) {
+	    hex[2*i] = digits[((unsigned char) raw[i]) >> 4];
+	    hex[2*i+1] = digits[((unsigned char) raw[i]) & 0xf];
+	} // for
+	return hex;
+    } // to_hex
+
+    /** Root of a tree digest: hash of the digests of the chunks followed by the size */
+    std::string tree_root(OksSystem::ContentHash::algorithm_t algorithm, const std::vector<std::string> &leaves, uint64_t size) {
+	std::unique_ptr<Hasher> hasher = make_hasher(algorithm);
+	for(size_t i=0;i<leaves.size();i++) {
+	    hasher->update((const unsigned char *) leaves[i].data(),leaves[i].size());
+	} // for
+	unsigned char bytes[8];
+	for(int i=0;i<8;i++) bytes[i] = (unsigned char) (size >> (8*i));
+	hasher->update(bytes,8);
+	return hasher->digest();
+    } // tree_root
+
+    /** Page aligned read buffer, one per thread */
+    class ReadBuffer {
+	void *m_data;
+    public:
+	ReadBuffer() : m_data(0) {
+	    if (0!=::posix_memalign(&m_data,4096,OksSystem::ContentHash::BUFFER_SIZE)) m_data = 0;
+	} // ReadBuffer
+	~ReadBuffer() { ::free(m_data); }
+	unsigned char *data() const { return (unsigned char *) m_data; }
+    } ; // ReadBuffer
+
+    unsigned char *read_buffer() {
+	thread_local ReadBuffer s_buffer;
+	return s_buffer.data();
+    } // read_buffer
+
+    /** Hashes a file from its current position to its end
+      * \return 0 or the error code
+      */
+    int hash_stream(int fd, Hasher &hasher, uint64_t &size) {
+	unsigned char *buffer = read_buffer();
+	if (0==buffer) return ENOMEM;
+	size = 0;
+	while(true) {
+	    const ssize_t n = ::read(fd,buffer,OksSystem::ContentHash::BUFFER_SIZE);
+	    if (n<0) {
+		if (EINTR==errno) continue;
+		return errno;
+	    } // if
+	    if (0==n) return 0;
+	    hasher.update(buffer,n);
+	    size += n;
+	} // while
+    } // hash_stream
+
+    /** Hashes a file from its current position to its end, in chunks of \c CHUNK_SIZE bytes like a regular file
+      * \return 0 or the error code
+      */
+    int hash_stream_chunks(int fd, OksSystem::ContentHash::algorithm_t algorithm, std::vector<std::string> &leaves, uint64_t &size) {
+	unsigned char *buffer = read_buffer();
+	if (0==buffer) return ENOMEM;
+	std::unique_ptr<Hasher> hasher = make_hasher(algorithm);
+	size_t in_chunk = 0;
+	size = 0;
+	while(true) {
+	    const ssize_t n = ::read(fd,buffer,OksSystem::ContentHash::BUFFER_SIZE);
+	    if (n<0) {
+		if (EINTR==errno) continue;
+		return errno;
+	    } // if
+	    if (0==n) break;
+	    for(size_t done = 0; done<(size_t) n; ) {
+		if (in_chunk==OksSystem::ContentHash::CHUNK_SIZE) { // a chunk is only closed when more data follows
+		    leaves.push_back(hasher->digest());
+		    hasher = make_hasher(algorithm);
+		    in_chunk = 0;
+		} // if
+		const size_t length = std::min((size_t) n-done,OksSystem::ContentHash::CHUNK_SIZE-in_chunk);
+		hasher->update(buffer+done,length);
+		in_chunk += length;
+		done += length;
+	    } // for
+	    size += n;
+	} // while
+	leaves.push_back(hasher->digest());
+	return 0;
+    } // hash_stream_chunks
+
+    /** Hashes a range of a file
+      * \return 0 or the error code
+      */
+    int hash_range(int fd, uint64_t offset, uint64_t length, Hasher &hasher) {
+	unsigned char *buffer = read_buffer();
+	if (0==buffer) return ENOMEM;
+	while(length>0) {
+	    const size_t wanted = (length<OksSystem::ContentHash::BUFFER_SIZE) ? length : OksSystem::ContentHash::BUFFER_SIZE;
+	    const ssize_t n = ::pread(fd,buffer,wanted,offset);
+	    if (n<0) {
+		if (EINTR==errno) continue;
+		return errno;
+	    } // if
+	    if (0==n) return EIO; // the file was truncated while being hashed
+	    hasher.update(buffer,n);
+	    offset += n;
+	    length -= n;
+	} // while
+	return 0;
+    } // hash_range
+
+    /** State of the hashing of one file */
+    struct Job {
+	std::string m_path;
+	OksSystem::ContentHash::algorithm_t m_algorithm;
+	int m_fd;
+	uint64_t m_size;
+	std::vector<std::string> m_leaves;
+	std::atomic<size_t> m_remaining;
+	std::atomic<int> m_error;
+	bool m_opened;
+	std::string m_digest;
+	Job(const std::string &path, OksSystem::ContentHash::algorithm_t algorithm) : m_path(path), m_algorithm(algorithm), m_fd(-1), m_size(0), m_remaining(0), m_error(0), m_opened(false) {}
+
+	void fail(int error) {
+	    int expected = 0;
+	    m_error.compare_exchange_strong(expected,error);
+	} // fail
+
+	void finish() {
+	    ::close(m_fd);
+	    m_fd = -1;
+	    if (0==m_error) m_digest = to_hex(tree_root(m_algorithm,m_leaves,m_size));
+	} // finish
+
+	void hash_chunk(size_t index) {
+	    if (0==m_error) {
+		std::unique_ptr<Hasher> hasher = make_hasher(m_algorithm);
+		const uint64_t offset = index*OksSystem::ContentHash::CHUNK_SIZE;
+		const uint64_t length = std::min<uint64_t>(OksSystem::ContentHash::CHUNK_SIZE,m_size-offset);
+		const int error = hash_range(m_fd,offset,length,*hasher);
+		if (0==error) {
+		    m_leaves[index] = hasher->digest();
+		} else {
+		    fail(error);
+		} // if
+	    } // if
+	    if (1==m_remaining--) finish();
+	} // hash_chunk
+
+	/** Opens the file and hashes it, the chunks of a tree digest are given to the pool (if any) */
+	void run(OksSystem::WorkerPool *pool) {
+	    m_fd = ::open(m_path.c_str(),O_RDONLY | O_CLOEXEC | O_NOATIME);
+	    if (m_fd<0 && EPERM==errno) m_fd = ::open(m_path.c_str(),O_RDONLY | O_CLOEXEC);
+	    if (m_fd<0) {
+		fail(errno);
+		return;
+	    } // if
+	    m_opened = true;
+	    struct stat status;
+	    if (0!=::fstat(m_fd,&status)) {
+		fail(errno);
+		::close(m_fd);
+		return;
+	    } // if
+	    ::posix_fadvise(m_fd,0,0,POSIX_FADV_SEQUENTIAL);
+	    if (! OksSystem::ContentHash::is_tree(m_algorithm)) {
+		std::unique_ptr<Hasher> hasher = make_hasher(m_algorithm);
+		const int error = hash_stream(m_fd,*hasher,m_size);
+		::close(m_fd);
+		m_fd = -1;
+		if (0!=error) {
+		    fail(error);
+		} else {
+		    m_digest = to_hex(hasher->digest());
+		} // if
+		return;
+	    } // if
+	    if (! S_ISREG(status.st_mode)) { // size unknown, the chunks are hashed as they are read
+		const int error = hash_stream_chunks(m_fd,m_algorithm,m_leaves,m_size);
+		::close(m_fd);
+		m_fd = -1;
+		if (0!=error) {
+		    fail(error);
+		} else {
+		    m_digest = to_hex(tree_root(m_algorithm,m_leaves,m_size));
+		} // if
+		return;
+	    } // if
+	    m_size = status.st_size;
+	    const size_t chunks = (m_size>0) ? (m_size+OksSystem::ContentHash::CHUNK_SIZE-1)/OksSystem::ContentHash::CHUNK_SIZE : 1;
+	    m_leaves.resize(chunks);
+	    m_remaining = chunks;
+	    for(size_t i=0;i<chunks;i++) {
+		if (pool) {
+		    pool->submit([this,i]() { hash_chunk(i); });
+		} else {
+		    hash_chunk(i);
+		} // if
+	    } // for
+	} // run
+    } ; // Job
+
+} // anonymous namespace
+
+/** \return the name of an algorithm, like \c "sha256" or \c "xxh64-tree" */
+
+const char *OksSystem::ContentHash::name(algorithm_t algorithm) throw() {
+    switch(algorithm) {
+	case XXH64: return "xxh64";
+	case XXH64_TREE: return "xxh64-tree";
+	case SHA256: return "sha256";
+	case SHA256_TREE: return "sha256-tree";
+	case XXH128: return "xxh128";
+	case XXH128_TREE: return "xxh128-tree";
+    } // switch
+    return "unknown";
+} // name
+
+bool OksSystem::ContentHash::is_tree(algorithm_t algorithm) throw() {
+    return XXH64_TREE==algorithm || SHA256_TREE==algorithm || XXH128_TREE==algorithm;
+} // is_tree
+
+/** Hashes a block of memory, the tree variants split it in chunks like a file (sequentially)
+  * \param data start of the block
+  * \param size size of the block
+  * \param algorithm the algorithm
+  * \return the digest
+  */
+
+std::string OksSystem::ContentHash::hash(const void *data, size_t size, algorithm_t algorithm) {
+    const unsigned char *bytes = (const unsigned char *) data;
+    if (! is_tree(algorithm)) {
+	std::unique_ptr<Hasher> hasher = make_hasher(algorithm);
+	hasher->update(bytes,size);
+	return to_hex(hasher->digest());
+    } // if
+    std::vector<std::string> leaves;
+    size_t offset = 0;
+    do {
+	const size_t length = std::min(CHUNK_SIZE,size-offset);
+	std::unique_ptr<Hasher> hasher = make_hasher(algorithm);
+	hasher->update(bytes+offset,length);
+	leaves.push_back(hasher->digest());
+	offset += length;
+    } while(offset<size);
+    return to_hex(tree_root(algorithm,leaves,size));
+} // hash
+
+/** Hashes the content of a file.
+  * The plain algorithms read the file sequentially in the calling thread,
+  * the tree algorithms hash the chunks of large files in parallel.
+  * \param file the file
+  * \param algorithm the algorithm
+  * \param workers maximum number of threads for the tree algorithms, 0 means \c WorkerPool::default_size()
+  * \return the digest
+  * \exception OksSystem::OpenFileIssue if the file cannot be opened
+  * \exception OksSystem::ReadIssue if the file cannot be read
+  */
+
+std::string OksSystem::ContentHash::hash(const File &file, algorithm_t algorithm, unsigned int workers) {
+    Job job(file.full_name(),algorithm);
+    struct stat status;
+    if (is_tree(algorithm) && 0==::stat(file.c_full_name(),&status) && (size_t) status.st_size>CHUNK_SIZE && 1!=workers) {
+	const size_t chunks = (status.st_size+CHUNK_SIZE-1)/CHUNK_SIZE;
+	if (0==workers) workers = WorkerPool::default_size();
+	WorkerPool pool((workers<chunks) ? workers : chunks);
+	job.run(&pool);
+	pool.wait();
+    } else {
+	job.run(0);
+    } // if
+    if (0!=job.m_error) {
+	if (! job.m_opened) throw OksSystem::OpenFileIssue( ERS_HERE, job.m_error, file.c_full_name() );
+	throw OksSystem::ReadIssue( ERS_HERE, job.m_error, file.c_full_name() );
+    } // if
+    return job.m_digest;
+} // hash
+
+/** Hashes the content of many files.
+  * The files, and the chunks of large files for the tree algorithms, are shared between the workers.
+  * Errors do not stop the other files, they are reported in the results.
+  * \param files the files
+  * \param count the number of files
+  * \param algorithm the algorithm
+  * \param workers number of threads, 0 means \c WorkerPool::default_size()
+  * \return one result per file, in the same order as \c files
+  */
+
+OksSystem::ContentHash::result_list_t OksSystem::ContentHash::hash_many(const File *files, size_t count, algorithm_t algorithm, unsigned int workers) {
+    std::vector<std::unique_ptr<Job> > jobs;
+    for(size_t i=0;i<count;i++) {
+	jobs.push_back(std::unique_ptr<Job>(new Job(files[i].full_name(),algorithm)));
+    } // for
+    if (count>0) {
+	WorkerPool pool(workers);
+	for(size_t i=0;i<count;i++) {
+	    Job *job = jobs[i].get();
+	    pool.submit([job,&pool]() { job->run(&pool); });
+	} // for
+	pool.wait();
+    } // if
+    result_list_t results(count);
+    for(size_t i=0;i<count;i++) {
+	results[i].error = jobs[i]->m_error;
+	results[i].digest.swap(jobs[i]->m_digest);
+    } // for
+    return results;
+} // hash_many
+
+OksSystem::ContentHash::result_list_t OksSystem::ContentHash::hash_many(const std::vector<File> &files, algorithm_t algorithm, unsigned int workers) {
+    return hash_many(files.data(),files.size(),algorithm,workers);
+} // hash_many
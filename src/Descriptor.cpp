@@ -37,6 +37,16 @@ OksSystem::Descriptor::Descriptor(const File * file, int i_flags, mode_t perm) {
     open(file,i_flags,perm); 
 } // Descriptor
 
+/** Builds a descriptor object for a descriptor already opened. 
+  * The object takes ownership of the descriptor, it is closed with the object. 
+  * \param fd the open descriptor
+  * \param name the name of the file, used for error messages
+  */
+
+OksSystem::Descriptor::Descriptor(int fd, const std::string &name) : m_fd(fd), m_name(name) {
+    ERS_ASSERT( fd>=0 )
+} // Descriptor
+
 OksSystem::Descriptor::~Descriptor() {
     if (m_fd>=0) { 
 	close_safe(); 
@@ -72,10 +82,10 @@ void OksSystem::Descriptor::open(const File * file, int i_flags, mode_t perm) {
 
 void OksSystem::Descriptor::close() {
     const int status = ::close(m_fd); 
+    m_fd = -1 ; // released even if close fails, it must not be closed again
     if (status<0) {
 	throw OksSystem::CloseFileIssue( ERS_HERE, errno, m_name.c_str() ); 
     } // 
-    m_fd = -1 ;
 } // close
 
 
@@ -107,6 +117,10 @@ int OksSystem::Descriptor::fd() const throw() {
   return m_fd;
 } 
 
+const std::string & OksSystem::Descriptor::name() const throw() { 
+  return m_name;
+} 
+
 /**
  * \brief It flags the file descriptor to be closed after any call to the exec okssystem function.
  */
@@ -0,0 +1,319 @@
+/*
+ *  DescriptorStreamBuf.cxx
+ *  OksSystem
+ *
+ *  Stream buffer reading from or writing to a file descriptor.
+ *
+ */
+
+#include <algorithm>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "ers/ers.hpp"
+#include "ers/Assertion.hpp"
+
+#include "okssystem/DescriptorStreamBuf.hpp"
+#include "okssystem/File.hpp"
+#include "okssystem/exceptions.hpp"
+
+const size_t OksSystem::DescriptorStreamBuf::DEFAULT_BUFFER_SIZE = 64*1024;
+const size_t OksSystem::DescriptorStreamBuf::HUGE_PAGE_SIZE = 2*1024*1024;
+
+/** Default options: \c O_CLOEXEC and \c O_NOATIME, buffer in normal memory
+  * \param size size of the buffer
+  */
+
+OksSystem::DescriptorStreamBuf::Options::Options(size_t size) throw() {
+    buffer_size = size;
+    close_on_exec = true;
+    no_atime = true;
+    huge_pages = false;
+} // Options
+
+/** Opens a file with the flags given by the options.
+  * \c O_NOATIME is only allowed to the owner of the file, if it is refused the file is opened without it.
+  * \param file the file to open
+  * \param flags open flags, \c O_CLOEXEC and \c O_NOATIME are added following the options
+  * \param permissions permissions for a created file
+  * \param options the options
+  * \return the file descriptor
+  * \exception OksSystem::OpenFileIssue if the file cannot be opened
+  */
+
+int OksSystem::DescriptorStreamBuf::open(const File &file, int flags, mode_t permissions, const Options &options) {
+    if (options.close_on_exec) flags |= O_CLOEXEC;
+    int fd = -1;
+    if (options.no_atime && O_RDONLY==(flags & O_ACCMODE)) {
+	fd = ::open(file.c_full_name(),flags | O_NOATIME,permissions);
+	if (fd<0 && EPERM==errno) fd = ::open(file.c_full_name(),flags,permissions);
+    } else {
+	fd = ::open(file.c_full_name(),flags,permissions);
+    } // if
+    if (fd<0) {
+	throw OksSystem::OpenFileIssue( ERS_HERE, errno, file.c_full_name() );
+    } // if
+    return fd;
+} // open
+
+/** Builds a stream buffer on a descriptor.
+  * \param descriptor the descriptor, the stream buffer takes ownership of it
+  * \param output is the buffer used for writing (else for reading)
+  * \param options the options for the buffer
+  */
+
+OksSystem::DescriptorStreamBuf::DescriptorStreamBuf(Descriptor *descriptor, bool output, const Options &options) : m_descriptor(descriptor) {
+    ERS_PRECONDITION(descriptor!=0);
+    m_buffer = 0;
+    m_buffer_size = 0;
+    m_mapped = false;
+    m_output = output;
+    m_error = 0;
+    allocate(options);
+    if (m_output) {
+	setp(m_buffer,m_buffer+m_buffer_size);
+    } else {
+	setg(m_buffer,m_buffer,m_buffer);
+    } // if
+} // DescriptorStreamBuf
+
+/** Destructor, the pending output is written (errors are reported as warnings) and the descriptor is closed */
+
+OksSystem::DescriptorStreamBuf::~DescriptorStreamBuf() {
+    if (m_descriptor && m_output) {
+	try {
+	    flush();
+	} catch (ers::Issue &ex) {
+	    ers::warning(ex);
+	} // catch
+    } // if
+    if (m_mapped) {
+	::munmap(m_buffer,m_buffer_size);
+    } else {
+	delete[] m_buffer;
+    } // if
+} // ~DescriptorStreamBuf
+
+/** Allocates the buffer.
+  * Huge page buffers are first taken from the reserved huge pages (\c MAP_HUGETLB),
+  * else from normal pages with transparent huge pages requested (\c MADV_HUGEPAGE).
+  * Their size is rounded up to the size of a huge page.
+  */
+
+void OksSystem::DescriptorStreamBuf::allocate(const Options &options) {
+    m_buffer_size = (options.buffer_size>0) ? options.buffer_size : 1;
+    if (options.huge_pages) {
+	const size_t size = ((m_buffer_size+HUGE_PAGE_SIZE-1)/HUGE_PAGE_SIZE)*HUGE_PAGE_SIZE;
+	void *address = ::mmap(0,size,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,-1,0);
+	if (MAP_FAILED==address) {
+	    address = ::mmap(0,size,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+	    if (MAP_FAILED!=address) ::madvise(address,size,MADV_HUGEPAGE);
+	} // if
+	if (MAP_FAILED!=address) {
+	    m_buffer = (char *) address;
+	    m_buffer_size = size;
+	    m_mapped = true;
+	    return;
+	} // if
+    } // if
+    m_buffer = new char[m_buffer_size];
+} // allocate
+
+/** Writes data to the descriptor, retrying after interruptions and partial writes.
+  * \exception OksSystem::WriteIssue if the write fails
+  */
+
+void OksSystem::DescriptorStreamBuf::write_all(const char *data, size_t size) {
+    while(size>0) {
+	const ssize_t n = ::write(fd(),data,size);
+	if (n<0) {
+	    if (EINTR==errno) continue;
+	    m_error = errno;
+	    throw OksSystem::WriteIssue( ERS_HERE, m_error, m_descriptor->name().c_str() );
+	} // if
+	data += n;
+	size -= n;
+    } // while
+} // write_all
+
+/** Writes the content of the output buffer */
+
+void OksSystem::DescriptorStreamBuf::flush() {
+    const size_t size = pptr()-pbase();
+    if (size>0) {
+	write_all(pbase(),size);
+	setp(m_buffer,m_buffer+m_buffer_size);
+    } // if
+} // flush
+
+/** Fills the input buffer with one \c read.
+  * \exception OksSystem::ReadIssue if the read fails
+  */
+
+OksSystem::DescriptorStreamBuf::int_type OksSystem::DescriptorStreamBuf::underflow() {
+    if (m_output || ! m_descriptor) return traits_type::eof();
+    if (gptr()<egptr()) return traits_type::to_int_type(*gptr());
+    while(true) {
+	const ssize_t n = ::read(fd(),m_buffer,m_buffer_size);
+	if (n<0) {
+	    if (EINTR==errno) continue;
+	    m_error = errno;
+	    throw OksSystem::ReadIssue( ERS_HERE, m_error, m_descriptor->name().c_str() );
+	} // if
+	if (0==n) return traits_type::eof();
+	setg(m_buffer,m_buffer,m_buffer+n);
+	return traits_type::to_int_type(*gptr());
+    } // while
+} // underflow
+
+OksSystem::DescriptorStreamBuf::int_type OksSystem::DescriptorStreamBuf::overflow(int_type c) {
+    if (! m_output || ! m_descriptor) return traits_type::eof();
+    flush();
+    if (traits_type::eq_int_type(c,traits_type::eof())) return traits_type::not_eof(c);
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+} // overflow
+
+/** Writes a block of characters, blocks at least as large as the buffer are written directly */
+
+std::streamsize OksSystem::DescriptorStreamBuf::xsputn(const char_type *data, std::streamsize size) {
+    if (! m_output || ! m_descriptor) return 0;
+    if (size>epptr()-pptr()) {
+	flush();
+	if ((size_t) size>=m_buffer_size) {
+	    write_all(data,size);
+	    return size;
+	} // if
+    } // if
+    memcpy(pptr(),data,size);
+    pbump(size);
+    return size;
+} // xsputn
+
+/** Reads a block of characters, blocks at least as large as the buffer are read directly */
+
+std::streamsize OksSystem::DescriptorStreamBuf::xsgetn(char_type *data, std::streamsize size) {
+    const std::streamsize buffered = std::min<std::streamsize>(egptr()-gptr(),size);
+    if (buffered>0) {
+	memcpy(data,gptr(),buffered);
+	gbump(buffered);
+    } // if
+    std::streamsize done = buffered;
+    if (size-done<(std::streamsize) m_buffer_size) {
+	return done + std::streambuf::xsgetn(data+done,size-done);
+    } // if
+    while(done<size && ! m_output && m_descriptor) {
+	const ssize_t n = ::read(fd(),data+done,size-done);
+	if (n<0) {
+	    if (EINTR==errno) continue;
+	    m_error = errno;
+	    throw OksSystem::ReadIssue( ERS_HERE, m_error, m_descriptor->name().c_str() );
+	} // if
+	if (0==n) break;
+	done += n;
+    } // while
+    return done;
+} // xsgetn
+
+/** Synchronises the buffer with the file: pending output is written,
+  * buffered input not consumed yet is given back, so that the file offset is the logical position.
+  */
+
+int OksSystem::DescriptorStreamBuf::sync() {
+    if (! m_descriptor) return 0;
+    if (m_output) {
+	flush();
+    } else if (gptr()<egptr()) {
+	if (::lseek(fd(),gptr()-egptr(),SEEK_CUR)<0) {
+	    m_error = errno;
+	    return -1;
+	} // if
+	setg(m_buffer,m_buffer,m_buffer);
+    } // if
+    return 0;
+} // sync
+
+OksSystem::DescriptorStreamBuf::pos_type OksSystem::DescriptorStreamBuf::seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode) {
+    if (! m_descriptor || 0!=sync()) return pos_type(off_type(-1));
+    const int whence = (std::ios_base::beg==direction) ? SEEK_SET : ((std::ios_base::cur==direction) ? SEEK_CUR : SEEK_END);
+    const off_t position = ::lseek(fd(),offset,whence);
+    if (position<0) {
+	m_error = errno;
+	return pos_type(off_type(-1));
+    } // if
+    return pos_type(position);
+} // seekoff
+
+OksSystem::DescriptorStreamBuf::pos_type OksSystem::DescriptorStreamBuf::seekpos(pos_type position, std::ios_base::openmode mode) {
+    return seekoff(off_type(position),std::ios_base::beg,mode);
+} // seekpos
+
+int OksSystem::DescriptorStreamBuf::fd() const throw() {
+    return m_descriptor ? m_descriptor->fd() : -1;
+} // fd
+
+size_t OksSystem::DescriptorStreamBuf::buffer_size() const throw() {
+    return m_buffer_size;
+} // buffer_size
+
+bool OksSystem::DescriptorStreamBuf::is_huge() const throw() {
+    return m_mapped;
+} // is_huge
+
+int OksSystem::DescriptorStreamBuf::error() const throw() {
+    return m_error;
+} // error
+
+/** Writes the pending output and closes the descriptor, reporting the errors of \c close
+  * \exception OksSystem::WriteIssue if the pending output cannot be written
+  * \exception OksSystem::CloseFileIssue if the descriptor cannot be closed
+  */
+
+void OksSystem::DescriptorStreamBuf::close() {
+    if (! m_descriptor) return;
+    std::unique_ptr<Descriptor> descriptor;
+    if (m_output) {
+	try {
+	    flush();
+	} catch (...) {
+	    descriptor.swap(m_descriptor);
+	    throw;
+	} // catch
+    } // if
+    descriptor.swap(m_descriptor);
+    descriptor->close();
+} // close
+
+/** Builds an input stream on a descriptor, I/O errors make the stream throw
+  * \param descriptor the descriptor, the stream takes ownership of it
+  * \param options the options for the buffer
+  */
+
+OksSystem::DescriptorInputStream::DescriptorInputStream(Descriptor *descriptor, const DescriptorStreamBuf::Options &options) : std::istream(0), m_buffer(descriptor,false,options) {
+    std::ios::rdbuf(&m_buffer);
+    exceptions(std::ios::badbit);
+} // DescriptorInputStream
+
+/** Builds an output stream on a descriptor, I/O errors make the stream throw
+  * \param descriptor the descriptor, the stream takes ownership of it
+  * \param options the options for the buffer
+  */
+
+OksSystem::DescriptorOutputStream::DescriptorOutputStream(Descriptor *descriptor, const DescriptorStreamBuf::Options &options) : std::ostream(0), m_buffer(descriptor,true,options) {
+    std::ios::rdbuf(&m_buffer);
+    exceptions(std::ios::badbit);
+} // DescriptorOutputStream
+
+/** Flushes the stream and closes the descriptor, so that errors of the final write and of \c close are reported
+  * \exception OksSystem::WriteIssue if the pending output cannot be written
+  * \exception OksSystem::CloseFileIssue if the descriptor cannot be closed
+  */
+
+void OksSystem::DescriptorOutputStream::close() {
+    m_buffer.close();
+} // close
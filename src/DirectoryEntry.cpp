@@ -0,0 +1,96 @@
+/*
+ *  DirectoryEntry.cxx
+ *  OksSystem
+ *
+ *  Raw entry of a directory listing.
+ *
+ */
+
+#include "ers/ers.hpp"
+
+#include "okssystem/DirectoryEntry.hpp"
+#include "okssystem/File.hpp"
+
+/** Constructor
+  * \param directory shared path of the directory containing the entry
+  * \param name name of the entry
+  * \param inode inode number of the entry
+  * \param type the \c d_type of the entry (one of the \c DT_ constants)
+  * \param device the device of the directory containing the entry
+  */
+
+OksSystem::DirectoryEntry::DirectoryEntry(const path_ptr &directory, const char *name, ino_t inode, unsigned char type, dev_t device) : m_directory(directory), m_name(name) {
+    ERS_PRECONDITION(directory);
+    m_inode = inode;
+    m_device = device;
+    m_type = (type_t) type;
+} // DirectoryEntry
+
+const std::string & OksSystem::DirectoryEntry::name() const throw() {
+    return m_name;
+} // name
+
+const std::string & OksSystem::DirectoryEntry::directory() const throw() {
+    return *m_directory;
+} // directory
+
+/** \return the path of the entry, this is simply the directory path followed by the name */
+
+std::string OksSystem::DirectoryEntry::full_name() const {
+    const std::string &dir = *m_directory;
+    if (! dir.empty() && dir[dir.size()-1]=='/') return dir + m_name;
+    return dir + "/" + m_name;
+} // full_name
+
+ino_t OksSystem::DirectoryEntry::inode() const throw() {
+    return m_inode;
+} // inode
+
+/** Identity of the entry, obtained without any system call. 
+  * The device is the one of the directory being read, for a mount point the identity 
+  * is therefore the one of the directory hidden by the mount, not of the mounted root. 
+  * \return the device and inode of the entry
+  */
+
+OksSystem::FileId OksSystem::DirectoryEntry::id() const throw() {
+    return FileId(m_device,m_inode);
+} // id
+
+OksSystem::DirectoryEntry::type_t OksSystem::DirectoryEntry::type() const throw() {
+    return m_type;
+} // type
+
+bool OksSystem::DirectoryEntry::is_regular() const throw() {
+    return (m_type==REGULAR);
+} // is_regular
+
+bool OksSystem::DirectoryEntry::is_directory() const throw() {
+    return (m_type==DIRECTORY);
+} // is_directory
+
+bool OksSystem::DirectoryEntry::is_fifo() const throw() {
+    return (m_type==FIFO);
+} // is_fifo
+
+bool OksSystem::DirectoryEntry::is_symlink() const throw() {
+    return (m_type==SYMLINK);
+} // is_symlink
+
+/** Builds a File object for the entry.
+  * This canonicalizes the path, and therefore resolves symbolic links.
+  * \return the file object
+  */
+
+OksSystem::File OksSystem::DirectoryEntry::file() const {
+    return OksSystem::File(full_name());
+} // file
+
+/** Builds a File object for the entry, without resolving symbolic links.
+  * The path is built lexically, without any system call, so if the entry is a symbolic link 
+  * the file is the link itself, which can be inspected with \c File::link_status() and \c File::link_target(). 
+  * \return the file object
+  */
+
+OksSystem::File OksSystem::DirectoryEntry::link() const {
+    return OksSystem::File(full_name(),OksSystem::File::LEXICAL);
+} // link
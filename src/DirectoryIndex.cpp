@@ -0,0 +1,381 @@
+/*
+ *  DirectoryIndex.cxx
+ *  OksSystem
+ *
+ *  Persistent memory mapped index of a directory tree.
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "ers/ers.hpp"
+
+#include "okssystem/AtomicWriter.hpp"
+#include "okssystem/DirectoryIndex.hpp"
+#include "okssystem/DirectoryIterator.hpp"
+#include "okssystem/MapFile.hpp"
+#include "okssystem/exceptions.hpp"
+
+namespace {
+
+    /** Layout of the index file: header, directory records, entry records, strings.
+      * Everything is in host byte order, the index is a cache and is not meant to be portable.
+      */
+
+    struct IndexHeader {
+	char magic[8] ;
+	uint32_t version ;
+	uint32_t directory_count ;
+	uint64_t entry_count ;
+	uint64_t strings_size ;
+	uint64_t directories_offset ;
+	uint64_t entries_offset ;
+	uint64_t strings_offset ;
+	uint64_t data_size ;                                      // bytes actually used, the file is padded to a page
+	int64_t update_ns ;                                       // time just before the directories were checked
+    } ; // IndexHeader
+
+    struct DirectoryRecord {
+	uint64_t path_offset ;
+	uint64_t first_entry ;
+	uint32_t path_length ;
+	uint32_t entry_count ;
+	uint64_t device ;
+	uint64_t inode ;
+	int64_t modification_ns ;
+	int64_t change_ns ;
+    } ; // DirectoryRecord
+
+    struct EntryRecord {
+	uint64_t name_offset ;
+	uint64_t size ;
+	int64_t modification_ns ;
+	uint64_t inode ;
+	uint32_t name_length ;
+	uint32_t directory ;
+	uint8_t type ;
+	uint8_t padding[7] ;
+    } ; // EntryRecord
+
+    inline int64_t nanoseconds(const struct timespec &time) {
+	return (int64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+    } // nanoseconds
+
+    /** Index being built in memory */
+    struct IndexBuilder {
+	std::vector<DirectoryRecord> directories ;
+	std::vector<EntryRecord> entries ;
+	std::string strings ;
+
+	uint64_t add_string(std::string_view s) {
+	    const uint64_t offset = strings.size();
+	    strings.append(s.data(),s.size());
+	    return offset;
+	} // add_string
+
+	/** Starts a directory, its entries must be added next */
+	void add_directory(const std::string &path, const struct stat &status) {
+	    DirectoryRecord d;
+	    memset(&d,0,sizeof(d));
+	    d.path_length = path.size();
+	    d.path_offset = add_string(path);
+	    d.first_entry = entries.size();
+	    d.device = status.st_dev;
+	    d.inode = status.st_ino;
+	    d.modification_ns = nanoseconds(status.st_mtim);
+	    d.change_ns = nanoseconds(status.st_ctim);
+	    directories.push_back(d);
+	} // add_directory
+
+	void add_entry(std::string_view name, unsigned char type, uint64_t size, int64_t modification_ns, uint64_t inode) {
+	    EntryRecord e;
+	    memset(&e,0,sizeof(e));
+	    e.name_length = name.size();
+	    e.name_offset = add_string(name);
+	    e.size = size;
+	    e.modification_ns = modification_ns;
+	    e.inode = inode;
+	    e.type = type;
+	    e.directory = directories.size()-1;
+	    directories.back().entry_count++;
+	    entries.push_back(e);
+	} // add_entry
+    } ; // IndexBuilder
+
+    /** Checks that \c count records of \c record_size bytes starting at \c offset end before \c limit,
+      * without any addition or multiplication that could wrap.
+      */
+    inline bool fits(uint64_t offset, uint64_t count, uint64_t record_size, uint64_t limit) {
+	return offset<=limit && count<=(limit-offset)/record_size;
+    } // fits
+
+    /** \return the path of a subdirectory */
+    std::string child_path(const std::string &directory, std::string_view name) {
+	std::string path = directory;
+	if (path.empty() || path[path.size()-1]!='/') path += '/';
+	path.append(name.data(),name.size());
+	return path;
+    } // child_path
+
+} // anonymous namespace
+
+const char OksSystem::DirectoryIndex::MAGIC[8] = { 'O', 'K', 'S', 'D', 'I', 'D', 'X', '\0' };
+const uint32_t OksSystem::DirectoryIndex::VERSION = 2;
+
+std::string OksSystem::DirectoryIndex::Entry::full_name() const {
+    return child_path(std::string(directory),name);
+} // full_name
+
+OksSystem::DirectoryIndex::Statistics::Statistics() throw() {
+    directories_checked = 0;
+    directories_read = 0;
+    entries_reused = 0;
+    entries_read = 0;
+    written = false;
+} // Statistics
+
+/** Constructor, maps the index file if it exists and is valid for the tree.
+  * \param root the root of the tree
+  * \param index the index file, it is created or replaced by \c update()
+  */
+
+OksSystem::DirectoryIndex::DirectoryIndex(const File &root, const File &index) : m_root(root), m_index(index) {
+    m_data = 0;
+    load();
+} // DirectoryIndex
+
+OksSystem::DirectoryIndex::~DirectoryIndex() {
+    unload();
+} // ~DirectoryIndex
+
+/** Maps the index file and checks that it is consistent and describes the right tree.
+  * An index that cannot be used is ignored, it is replaced by the next \c update(). 
+  * \return \c true if the index is mapped
+  */
+
+bool OksSystem::DirectoryIndex::load() {
+    unload();
+    struct stat index_status;
+    if (0!=::stat(m_index.c_full_name(),&index_status)) return false;
+    const size_t size = index_status.st_size;
+    if (size<sizeof(IndexHeader) || (size % ::getpagesize())!=0) return false;
+    std::unique_ptr<MapFile> map(new MapFile(m_index.full_name(),size,0,true,false));
+    try {
+	map->map();
+    } catch (ers::Issue &) {
+	return false; // unreadable index, it will be rebuilt
+    } // catch
+    const char *data = (const char *) map->address();
+    const IndexHeader *header = (const IndexHeader *) data;
+    bool valid = (0==memcmp(header->magic,MAGIC,sizeof(MAGIC)) && header->version==VERSION && header->data_size<=size
+	&& header->directories_offset>=sizeof(IndexHeader) && header->directory_count>0
+	&& 0==header->directories_offset%8 && 0==header->entries_offset%8 && 0==header->strings_offset%8
+	&& fits(header->directories_offset,header->directory_count,sizeof(DirectoryRecord),header->entries_offset)
+	&& fits(header->entries_offset,header->entry_count,sizeof(EntryRecord),header->strings_offset)
+	&& fits(header->strings_offset,header->strings_size,1,header->data_size));
+    const DirectoryRecord *directories = (const DirectoryRecord *) (data+header->directories_offset);
+    const EntryRecord *entries = (const EntryRecord *) (data+header->entries_offset);
+    for(uint32_t i=0;valid && i<header->directory_count;i++) {
+	valid = fits(directories[i].path_offset,directories[i].path_length,1,header->strings_size)
+	    && fits(directories[i].first_entry,directories[i].entry_count,1,header->entry_count);
+    } // for
+    for(uint64_t i=0;valid && i<header->entry_count;i++) {
+	valid = fits(entries[i].name_offset,entries[i].name_length,1,header->strings_size) 
+	    && entries[i].directory<header->directory_count;
+    } // for
+    if (valid) {
+	const char *strings = data+header->strings_offset;
+	valid = (std::string_view(strings+directories[0].path_offset,directories[0].path_length)==m_root.full_name());
+    } // if
+    if (! valid) {
+	map->unmap();
+	return false;
+    } // if
+    m_map.swap(map);
+    m_data = data;
+    return true;
+} // load
+
+void OksSystem::DirectoryIndex::unload() {
+    if (m_map) {
+	m_map->unmap();
+	m_map.reset();
+    } // if
+    m_data = 0;
+} // unload
+
+const void *OksSystem::DirectoryIndex::directory_record(size_t index) const throw() {
+    const IndexHeader *header = (const IndexHeader *) m_data;
+    return m_data + header->directories_offset + index*sizeof(DirectoryRecord);
+} // directory_record
+
+const void *OksSystem::DirectoryIndex::entry_record(size_t index) const throw() {
+    const IndexHeader *header = (const IndexHeader *) m_data;
+    return m_data + header->entries_offset + index*sizeof(EntryRecord);
+} // entry_record
+
+/** Brings the index up to date with the tree, and writes it if anything changed.
+  * Entries previously returned by \c entry() are invalid after this call.
+  * Entries removed while their directory is read are not indexed.
+  * \return statistics about the update
+  * \exception OksSystem::OksSystemCallIssue if the root cannot be read
+  * \exception OksSystem::OpenFileIssue, OksSystem::WriteIssue or OksSystem::RenameFileIssue if the index cannot be written
+  */
+
+OksSystem::DirectoryIndex::Statistics OksSystem::DirectoryIndex::update() {
+    Statistics statistics;
+    const int64_t update_ns = FileFingerprint::clock_ns();
+    std::unordered_map<std::string_view, uint32_t> previous;
+    const char *strings = 0;
+    int64_t previous_update_ns = 0;
+    if (m_data) {
+	const IndexHeader *header = (const IndexHeader *) m_data;
+	strings = m_data + header->strings_offset;
+	previous_update_ns = header->update_ns;
+	for(uint32_t i=0;i<header->directory_count;i++) {
+	    const DirectoryRecord *d = (const DirectoryRecord *) directory_record(i);
+	    previous[std::string_view(strings+d->path_offset,d->path_length)] = i;
+	} // for
+    } // if
+    IndexBuilder builder;
+    std::deque<std::string> pending;
+    pending.push_back(m_root.full_name());
+    while(! pending.empty()) {
+	const std::string path = pending.front();
+	pending.pop_front();
+	struct stat status;
+	int error = 0;
+	if (0!=::lstat(path.c_str(),&status)) {
+	    error = errno;
+	} else if (! S_ISDIR(status.st_mode)) {
+	    error = ENOTDIR;
+	} // if
+	if (error) {
+	    if (path==m_root.full_name()) {
+		std::string message = "on directory " + path;
+		throw OksSystem::OksSystemCallIssue( ERS_HERE, error, "lstat", message.c_str() );
+	    } // if
+	    continue; // removed or replaced since its parent was read
+	} // if
+	std::unordered_map<std::string_view, uint32_t>::const_iterator known = previous.find(path);
+	if (known!=previous.end()) {
+	    statistics.directories_checked++;
+	    const DirectoryRecord *d = (const DirectoryRecord *) directory_record(known->second);
+	    // times too close to the previous update are racy: the directory may have changed after it was listed, in the same tick
+	    const int64_t latest = d->modification_ns>d->change_ns ? d->modification_ns : d->change_ns;
+	    if (d->inode==(uint64_t) status.st_ino && d->device==(uint64_t) status.st_dev
+		&& d->modification_ns==nanoseconds(status.st_mtim) && d->change_ns==nanoseconds(status.st_ctim)
+		&& latest+FileFingerprint::RACY_NS<=previous_update_ns) {
+		builder.add_directory(path,status);
+		for(uint32_t i=0;i<d->entry_count;i++) {
+		    const EntryRecord *e = (const EntryRecord *) entry_record(d->first_entry+i);
+		    const std::string_view name(strings+e->name_offset,e->name_length);
+		    builder.add_entry(name,e->type,e->size,e->modification_ns,e->inode);
+		    if (e->type==DT_DIR) pending.push_back(child_path(path,name));
+		} // for
+		statistics.entries_reused += d->entry_count;
+		continue;
+	    } // if
+	} // if
+	statistics.directories_read++;
+	builder.add_directory(path,status);
+	try {
+	    DirectoryIterator listing(AT_FDCWD,path,path);
+	    for(const DirectoryEntry *entry = listing.next(); entry; entry = listing.next()) {
+		struct stat entry_status;
+		if (0!=::fstatat(listing.fd(),entry->name().c_str(),&entry_status,AT_SYMLINK_NOFOLLOW)) {
+		    if (ENOENT!=errno) {
+			std::string message = "on file " + entry->full_name();
+			ers::warning(OksSystem::OksSystemCallIssue( ERS_HERE, errno, "fstatat", message.c_str() ));
+		    } // if
+		    continue; // removed since the directory was read, or unusable, not indexed
+		} // if
+		builder.add_entry(entry->name(),entry->type(),entry_status.st_size,nanoseconds(entry_status.st_mtim),entry->inode());
+		statistics.entries_read++;
+		if (entry->is_directory()) pending.push_back(entry->full_name());
+	    } // for
+	} catch (OksSystem::OksSystemCallIssue &ex) {
+	    if (path==m_root.full_name()) throw;
+	    ers::warning(ex); // unreadable subdirectory, indexed as empty
+	} // catch
+    } // while
+    const bool changed = (0==m_data) || statistics.directories_read>0 || statistics.directories_checked!=directory_count();
+    if (! changed) return statistics;
+    // layout of the new index
+    IndexHeader header;
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,MAGIC,sizeof(MAGIC));
+    header.version = VERSION;
+    header.directory_count = builder.directories.size();
+    header.entry_count = builder.entries.size();
+    header.strings_size = builder.strings.size();
+    header.directories_offset = sizeof(IndexHeader);
+    header.entries_offset = header.directories_offset + builder.directories.size()*sizeof(DirectoryRecord);
+    header.strings_offset = header.entries_offset + builder.entries.size()*sizeof(EntryRecord);
+    header.data_size = header.strings_offset + header.strings_size;
+    header.update_ns = update_ns;
+    const size_t page_size = ::getpagesize();
+    const size_t file_size = ((header.data_size + page_size - 1) / page_size) * page_size;
+    // written to a private temporary file, flushed and renamed over the index, so readers and concurrent updates never see a partial index
+    AtomicWriter writer(m_index);
+    writer.write(&header,sizeof(header));
+    writer.write(builder.directories.data(),builder.directories.size()*sizeof(DirectoryRecord));
+    writer.write(builder.entries.data(),builder.entries.size()*sizeof(EntryRecord));
+    writer.write(builder.strings.data(),builder.strings.size());
+    const std::vector<char> padding(file_size-header.data_size,0);
+    writer.write(padding.data(),padding.size());
+    unload();
+    writer.commit();
+    statistics.written = true;
+    load();
+    return statistics;
+} // update
+
+bool OksSystem::DirectoryIndex::is_loaded() const throw() {
+    return (0!=m_data);
+} // is_loaded
+
+size_t OksSystem::DirectoryIndex::size() const throw() {
+    if (0==m_data) return 0;
+    return ((const IndexHeader *) m_data)->entry_count;
+} // size
+
+size_t OksSystem::DirectoryIndex::directory_count() const throw() {
+    if (0==m_data) return 0;
+    return ((const IndexHeader *) m_data)->directory_count;
+} // directory_count
+
+/** \param index the index of the entry, between 0 and \c size()
+  * \return the entry, its strings are valid until the index is updated or destroyed
+  */
+
+OksSystem::DirectoryIndex::Entry OksSystem::DirectoryIndex::entry(size_t index) const throw() {
+    const IndexHeader *header = (const IndexHeader *) m_data;
+    const char *strings = m_data + header->strings_offset;
+    const EntryRecord *e = (const EntryRecord *) entry_record(index);
+    const DirectoryRecord *d = (const DirectoryRecord *) directory_record(e->directory);
+    Entry result;
+    result.directory = std::string_view(strings+d->path_offset,d->path_length);
+    result.name = std::string_view(strings+e->name_offset,e->name_length);
+    result.type = (DirectoryEntry::type_t) e->type;
+    result.size = e->size;
+    result.modification_ns = e->modification_ns;
+    result.inode = e->inode;
+    return result;
+} // entry
+
+const OksSystem::File & OksSystem::DirectoryIndex::root() const throw() {
+    return m_root;
+} // root
+
+const OksSystem::File & OksSystem::DirectoryIndex::index() const throw() {
+    return m_index;
+} // index
@@ -0,0 +1,228 @@
+/*
+ *  DirectoryIterator.cxx
+ *  OksSystem
+ *
+ *  Streaming iteration over the entries of a directory.
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "ers/ers.hpp"
+
+#include "okssystem/DirectoryIterator.hpp"
+#include "okssystem/File.hpp"
+#include "okssystem/exceptions.hpp"
+
+namespace {
+
+    /** Layout of the records returned by \c getdents64 */
+    struct linux_dirent64 {
+	ino64_t        d_ino;
+	off64_t        d_off;
+	unsigned short d_reclen;
+	unsigned char  d_type;
+	char           d_name[];
+    } ; 
+
+} // anonymous namespace
+
+const size_t OksSystem::DirectoryIterator::BUFFER_SIZE = 64 * 1024;
+
+// --------------------------------------
+// iterator
+// --------------------------------------
+
+OksSystem::DirectoryIterator::iterator::iterator() throw() {
+    m_owner = 0;
+    m_entry = 0;
+} // iterator
+
+/** Builds an iterator positioned on the next entry of a directory 
+  * \param owner the directory being read 
+  */
+
+OksSystem::DirectoryIterator::iterator::iterator(DirectoryIterator *owner) {
+    m_owner = owner;
+    m_entry = 0;
+    ++(*this);
+} // iterator
+
+OksSystem::DirectoryIterator::iterator::reference OksSystem::DirectoryIterator::iterator::operator*() const throw() {
+    return *m_entry;
+} // operator*
+
+OksSystem::DirectoryIterator::iterator::pointer OksSystem::DirectoryIterator::iterator::operator->() const throw() {
+    return m_entry;
+} // operator->
+
+OksSystem::DirectoryIterator::iterator & OksSystem::DirectoryIterator::iterator::operator++() {
+    if (m_owner) {
+	m_entry = m_owner->next();
+	if (0==m_entry) m_owner = 0;
+    } // if
+    return *this;
+} // operator++
+
+bool OksSystem::DirectoryIterator::iterator::operator==(const iterator &other) const throw() {
+    return (m_owner==other.m_owner && m_entry==other.m_entry);
+} // operator==
+
+bool OksSystem::DirectoryIterator::iterator::operator!=(const iterator &other) const throw() {
+    return ! ((*this)==other);
+} // operator!=
+
+// --------------------------------------
+// DirectoryIterator
+// --------------------------------------
+
+/** Constructor, opens the directory 
+  * \param directory the directory to read
+  * \param buffer_size size of the buffer used to read entries from the kernel
+  * \exception OksSystem::OksSystemCallIssue if the directory cannot be opened 
+  */
+
+OksSystem::DirectoryIterator::DirectoryIterator(const File &directory, size_t buffer_size) :
+    m_buffer(buffer_size), 
+    m_entry(DirectoryEntry::path_ptr(new std::string(directory.full_name())),"",0,DT_UNKNOWN) {
+    ERS_PRECONDITION(buffer_size>=sizeof(struct linux_dirent64)+NAME_MAX+1);
+    m_count = 0;
+    m_position = 0;
+    m_fd = -1;
+    open(AT_FDCWD,directory.c_full_name(),0);
+} // DirectoryIterator
+
+/** Constructor, opens a directory relative to an open directory.
+  * This avoids resolving the full path of the directory again. 
+  * \param parent_fd descriptor of the directory containing the directory to read (or \c AT_FDCWD)
+  * \param name name of the directory relative to \c parent_fd, symbolic links are not followed
+  * \param path full path of the directory, used for the entries and for error messages 
+  * \param buffer_size size of the buffer used to read entries from the kernel
+  * \exception OksSystem::OksSystemCallIssue if the directory cannot be opened 
+  */
+
+OksSystem::DirectoryIterator::DirectoryIterator(int parent_fd, const std::string &name, const std::string &path, size_t buffer_size) :
+    m_buffer(buffer_size), 
+    m_entry(DirectoryEntry::path_ptr(new std::string(path)),"",0,DT_UNKNOWN) {
+    ERS_PRECONDITION(buffer_size>=sizeof(struct linux_dirent64)+NAME_MAX+1);
+    m_count = 0;
+    m_position = 0;
+    m_fd = -1;
+    open(parent_fd,name.c_str(),O_NOFOLLOW);
+} // DirectoryIterator
+
+OksSystem::DirectoryIterator::~DirectoryIterator() {
+    if (m_fd>=0) {
+	::close(m_fd);
+    } // if
+} // ~DirectoryIterator
+
+/** Opens the directory, and records its device for the identity of the entries
+  * \param parent_fd descriptor of the directory \c name is relative to, or \c AT_FDCWD
+  * \param name the name of the directory
+  * \param flags additional flags for \c openat
+  */
+
+void OksSystem::DirectoryIterator::open(int parent_fd, const char *name, int flags) {
+    m_fd = ::openat(parent_fd,name,O_RDONLY | O_DIRECTORY | O_CLOEXEC | flags);
+    if (m_fd<0) {
+	std::string message = "on directory " + path();
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "open", message.c_str() );
+    } // if
+    struct stat directory_status;
+    if (0==::fstat(m_fd,&directory_status)) {
+	m_entry.m_device = directory_status.st_dev;
+    } // if
+} // open
+
+/** Reads the next batch of entries from the kernel 
+  * \return \c false at the end of the directory 
+  */
+
+bool OksSystem::DirectoryIterator::fill() {
+    const long count = ::syscall(SYS_getdents64,m_fd,&m_buffer[0],m_buffer.size());
+    if (count<0) {
+	std::string message = "on directory " + path();
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "getdents64", message.c_str() );
+    } // if
+    m_count = count;
+    m_position = 0;
+    return (count>0);
+} // fill
+
+/** Reads the next entry of the directory.
+  * The entries . and .. are skipped. 
+  * If the file system does not report the type of an entry, it is obtained 
+  * with a \c fstatat relative to the directory (symbolic links are not followed). 
+  * \return pointer to the entry, it is valid until the next call, or null at end of directory 
+  * \exception OksSystem::OksSystemCallIssue if the directory cannot be read
+  */
+
+const OksSystem::DirectoryEntry* OksSystem::DirectoryIterator::next() {
+    if (m_fd<0) return 0;
+    while(true) {
+	if (m_position>=m_count) {
+	    if (! fill()) return 0;
+	} // if 
+	const struct linux_dirent64 *d = (const struct linux_dirent64 *) &m_buffer[m_position];
+	m_position += d->d_reclen;
+	const char *name = d->d_name;
+	if (name[0]=='.' && (name[1]=='\0' || (name[1]=='.' && name[2]=='\0'))) continue;
+	unsigned char type = d->d_type;
+	if (type==DT_UNKNOWN) {
+	    struct stat entry_status;
+	    if (0==::fstatat(m_fd,name,&entry_status,AT_SYMLINK_NOFOLLOW)) {
+		type = IFTODT(entry_status.st_mode);
+	    } 
+	} // file system does not report types 
+	m_entry.m_name.assign(name);
+	m_entry.m_inode = d->d_ino;
+	m_entry.m_type = (DirectoryEntry::type_t) type;
+	return &m_entry;
+    } // while
+} // next
+
+OksSystem::DirectoryIterator::iterator OksSystem::DirectoryIterator::begin() {
+    return iterator(this);
+} // begin
+
+OksSystem::DirectoryIterator::iterator OksSystem::DirectoryIterator::end() throw() {
+    return iterator();
+} // end
+
+/** Closes the directory, no further entries are returned 
+  * \exception OksSystem::OksSystemCallIssue if \c close fails
+  */
+
+void OksSystem::DirectoryIterator::close() {
+    if (m_fd<0) return;
+    const int status = ::close(m_fd);
+    m_fd = -1;
+    if (status<0) {
+	std::string message = "on directory " + path();
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "close", message.c_str() );
+    } // if
+} // close
+
+/** Gives up the ownership of the directory descriptor.
+  * The caller becomes responsible for closing it, no further entries are returned. 
+  * \return the descriptor of the directory
+  */
+
+int OksSystem::DirectoryIterator::release() throw() {
+    const int fd = m_fd;
+    m_fd = -1;
+    return fd;
+} // release
+
+int OksSystem::DirectoryIterator::fd() const throw() {
+    return m_fd;
+} // fd
+
+const std::string & OksSystem::DirectoryIterator::path() const throw() {
+    return m_entry.directory();
+} // path
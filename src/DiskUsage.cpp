@@ -0,0 +1,134 @@
+/*
+ *  DiskUsage.cxx
+ *  OksSystem
+ *
+ *  Space used by directory trees.
+ *
+ */
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+#include "okssystem/DiskUsage.hpp"
+#include "okssystem/File.hpp"
+#include "okssystem/FileStatus.hpp"
+#include "okssystem/TreeWalker.hpp"
+
+namespace {
+
+    const size_t SHARD_COUNT = 32;
+
+    /** Partial results, split in shards protected by their own mutex so that workers rarely wait on each other */
+    struct UsageShard {
+	std::mutex m_mutex ;
+	OksSystem::DiskUsage::usage_map_t m_entries ;             // usage by entry of the root
+	std::unordered_set<OksSystem::FileId> m_linked ;          // files with several links already counted
+    } ; // UsageShard
+
+    /** \return the name of the entry of the root directory containing a path */
+    std::string top_entry(const std::string &path, size_t root_length) {
+	size_t start = root_length;
+	while(start<path.size() && path[start]=='/') start++;
+	const std::string::size_type end = path.find('/',start);
+	return path.substr(start,(end==std::string::npos) ? std::string::npos : end-start);
+    } // top_entry
+
+} // anonymous namespace
+
+OksSystem::DiskUsage::Usage::Usage() throw() {
+    apparent_bytes = 0;
+    allocated_bytes = 0;
+    files = 0;
+    directories = 0;
+    hard_links = 0;
+} // Usage
+
+void OksSystem::DiskUsage::Usage::add(const FileStatus &status) throw() {
+    apparent_bytes += status.size();
+    allocated_bytes += (size_t) status.blocks() * 512;
+    if (status.is_directory()) {
+	directories++;
+    } else {
+	files++;
+    } // if
+} // add
+
+OksSystem::DiskUsage::Usage & OksSystem::DiskUsage::Usage::operator+=(const Usage &other) throw() {
+    apparent_bytes += other.apparent_bytes;
+    allocated_bytes += other.allocated_bytes;
+    files += other.files;
+    directories += other.directories;
+    hard_links += other.hard_links;
+    return *this;
+} // operator+=
+
+OksSystem::DiskUsage::DiskUsage() throw() {
+    m_elapsed_time = 0.0;
+    m_errors = 0;
+} // DiskUsage
+
+/** Computes the disk usage of a tree.
+  * Unreadable directories are skipped, their own size is counted but not their content,
+  * and they are counted in \c errors(). 
+  * \param root the root of the tree, if it is not a directory only its own usage is counted
+  * \param workers number of threads, 0 means one per hardware thread
+  * \exception OksSystem::OksSystemCallIssue if the root cannot be queried
+  */
+
+OksSystem::DiskUsage::DiskUsage(const File &root, unsigned int workers) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    m_errors = 0;
+    const FileStatus root_status = root.link_status();
+    m_total.add(root_status);
+    if (root_status.is_directory()) {
+	std::unique_ptr<UsageShard[]> shards(new UsageShard[SHARD_COUNT]);
+	const size_t root_length = root.full_name().size();
+	TreeWalker walker(workers);
+	walker.ignore_errors(true);
+	const TreeWalker::Statistics statistics = walker.walk(root,[&shards,root_length](const DirectoryEntry &entry, const FileStatus &status, unsigned int depth) {
+	    const std::string top = (1==depth) ? entry.name() : top_entry(entry.directory(),root_length);
+	    const bool linked = ! status.is_directory() && status.links()>1;
+	    bool counted = false;
+	    if (linked) {
+		const FileId id = status.id();
+		UsageShard &s = shards[id.hash() % SHARD_COUNT];
+		std::lock_guard<std::mutex> lock(s.m_mutex);
+		counted = ! s.m_linked.insert(id).second;
+	    } // if
+	    UsageShard &s = shards[std::hash<std::string>()(top) % SHARD_COUNT];
+	    std::lock_guard<std::mutex> lock(s.m_mutex);
+	    Usage &usage = s.m_entries[top];
+	    if (counted) {
+		usage.hard_links++;
+	    } else {
+		usage.add(status);
+	    } // if
+	});
+	m_errors = statistics.errors;
+	for(size_t i=0;i<SHARD_COUNT;i++) {
+	    for(usage_map_t::const_iterator pos = shards[i].m_entries.begin(); pos!=shards[i].m_entries.end(); ++pos) {
+		m_entries[pos->first] += pos->second;
+		m_total += pos->second;
+	    } // for
+	} // for
+    } // if
+    m_elapsed_time = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+} // DiskUsage
+
+const OksSystem::DiskUsage::Usage & OksSystem::DiskUsage::total() const throw() {
+    return m_total;
+} // total
+
+const OksSystem::DiskUsage::usage_map_t & OksSystem::DiskUsage::entries() const throw() {
+    return m_entries;
+} // entries
+
+double OksSystem::DiskUsage::elapsed_time() const throw() {
+    return m_elapsed_time;
+} // elapsed_time
+
+size_t OksSystem::DiskUsage::errors() const throw() {
+    return m_errors;
+} // errors
@@ -608,7 +608,7 @@ OksSystem::Process OksSystem::Executable::start(const param_collection &params,
 
 std::string OksSystem::Executable::to_string(const param_collection &params) const {
     std::ostringstream stream;
-    stream << m_full_name;
+    stream << full_name();
     for(param_collection::const_iterator pos=params.begin();pos!=params.end();++pos) {
 	stream << " " << (*pos);
     } // for
@@ -22,19 +22,30 @@
 #include <sstream>
 #include <fstream>
 #include <pwd.h>
+#include <ctype.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string.h>
+#include <sys/sysmacros.h>
 
 #include "ers/ers.hpp"
 
 #include "okssystem/File.hpp"
 #include "okssystem/exceptions.hpp"
 #include "okssystem/Executable.hpp"
+#include "okssystem/Descriptor.hpp"
+#include "okssystem/WorkerPool.hpp"
 #include "okssystem/User.hpp"
+#include "okssystem/DirectoryIterator.hpp"
 
 #define SPACE_CHAR ' ' 
 
 const char * const OksSystem::File::HUMAN_SIZE_STR[] = { "B", "KB", "MB", "GB" };
 const char * const OksSystem::File::HUMAN_OPEN_STR[] = { "READ", "WRITE", "NOBLOCK", "APPEND", "CREATE", "TRUNCATE","EXCLUSIVE"  };
 const char * const OksSystem::File::FILE_COMMAND_PATH = "/usr/bin/file";
+const size_t OksSystem::File::SNIFF_SIZE = 1024;
+const unsigned int OksSystem::File::STAT_WORKERS = 16;
 const char * const OksSystem::File::FILE_FLAG_STR = "-rwxS";
 const char * const OksSystem::File::FILE_PROTOCOL = "file";
 
@@ -155,6 +166,13 @@ OksSystem::File OksSystem::File::from_url(const std::string &url) {
     return File(path);
 } // from_url
 
+namespace {
+
+    std::mutex s_working_directory_mutex ;                        // protects the cached working directory
+    std::string s_working_directory ;                             // cached working directory, empty if not known
+
+} // anonymous namespace
+
 /** \return a string containing the working directory for the process */
 
 std::string OksSystem::File::working_directory() {
@@ -168,15 +186,36 @@ std::string OksSystem::File::working_directory() {
     throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "getcwd", message.c_str() );
 } // working_directory 
 
+/** Sets the working directory of the process.
+  * This also refreshes the working directory cached for lexical names. 
+  * \param dir the new working directory
+  */
+
 void OksSystem::File::working_directory(const File &dir) {
     const char * path = dir.c_full_name(); 
+    std::lock_guard<std::mutex> lock(s_working_directory_mutex);
     const int status = ::chdir(path); 
     if (status<0) {
       std::string message = "on directory " + dir.full_name(); 
       throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "chdir", message.c_str() );
     }
+    s_working_directory = dir.full_name();
 } // working_directory
 
+/** Gives the working directory used to build lexical names.
+  * The directory is obtained once with \c getcwd and cached, 
+  * it is refreshed when the working directory is changed with \c working_directory(const File&).
+  * \return the cached working directory 
+  */
+
+std::string OksSystem::File::cached_working_directory() {
+    std::lock_guard<std::mutex> lock(s_working_directory_mutex);
+    if (s_working_directory.empty()) {
+	s_working_directory = working_directory();
+    } // if
+    return s_working_directory;
+} // cached_working_directory
+
 
 /** Expands a file containing a home directory reference (~user). 
   */
@@ -196,6 +235,37 @@ std::string OksSystem::File::expand_home(const std::string path) {
 } // home_directory
 
 
+/** Normalizes an absolute path without accessing the file system.
+  * Empty and \c . components are removed, \c .. components remove the preceding component. 
+  * Symbolic links are not resolved, so the result can differ from what \c realpath returns 
+  * when a \c .. follows a symbolic link. 
+  * \param path an absolute path
+  * \return the normalized path
+  */
+
+std::string OksSystem::File::normalize(const std::string &path) {
+    ERS_PRECONDITION(! path.empty() && path[0]==SLASH_CHAR);
+    std::string result;
+    result.reserve(path.size());
+    for(std::string::size_type pos = 0; pos<path.size();) {
+	std::string::size_type slash = path.find(SLASH_CHAR,pos);
+	if (slash==std::string::npos) slash = path.size();
+	const std::string::size_type length = slash-pos;
+	if (length==0 || (length==1 && path[pos]==DOT_CHAR)) {
+	    // empty or current directory
+	} else if (length==2 && path[pos]==DOT_CHAR && path[pos+1]==DOT_CHAR) {
+	    const std::string::size_type last = result.rfind(SLASH_CHAR);
+	    result.erase((last==std::string::npos) ? 0 : last);
+	} else {
+	    result += SLASH_CHAR;
+	    result.append(path,pos,length);
+	} // if
+	pos = slash+1;
+    } // for
+    if (result.empty()) return std::string(1,SLASH_CHAR);
+    return result;
+} // normalize
+
 /** Builds a prettyfied version of permissions. 
 * This should look similar to what \c ls returns with the -l flag
 * \param permissions the permission to beautify 
@@ -297,6 +367,15 @@ OksSystem::File::File(const std::string &name) {
     set_name(name); 
 } // File
 
+/** Constructor 
+  * \param name the name of the file
+  * \param mode how the name is turned into a full path, in \c LEXICAL mode no system call is done
+  */
+
+OksSystem::File::File(const std::string &name, name_mode_t mode) {
+    set_name(name,mode); 
+} // File
+
 /** Constructor 
   * \overload
   */
@@ -307,12 +386,11 @@ OksSystem::File::File(const char* c_name) {
     set_name(name); 
 } // File
 
-/** Constructor 
+/** Copy constructor, the name is copied without being canonicalized again 
 * \overload
 */
 
-OksSystem::File::File(const File& other) {
-    set_name(other.m_full_name);
+OksSystem::File::File(const File& other) : m_full_name(other.m_full_name) {
 } // File
 
 // --------------------------------------
@@ -322,7 +400,7 @@ OksSystem::File::File(const File& other) {
 
 
 OksSystem::File::operator std::string() const throw() {
-    return m_full_name;
+    return m_full_name.str();
 } // operator std::string
 
 OksSystem::File::operator const char*() const throw() {
@@ -338,7 +416,7 @@ OksSystem::File::operator bool() const throw() {
 } // operator bool
 
 /** Comparison operator 
-  * As path are canonicalized, we simply compare the full paths. 
+  * As path are canonicalized and interned, we simply compare the path handles. 
   * \param other file to compare this file to
   * \return true if both file are equal 
   * \note This comparison method does not taken hard links into account 
@@ -348,6 +426,25 @@ bool OksSystem::File::equals(const File &other) const throw() {
     return (m_full_name == other.m_full_name);
 } // operator==
 
+/** \return a hash of the path of the file, computed once when the path was interned */
+
+size_t OksSystem::File::hash() const throw() {
+    return m_full_name.hash();
+} // hash
+
+/** Computes a digest of the content of the file. 
+  * \param algorithm the hash algorithm, the tree variants hash large files in parallel
+  * \param workers maximum number of threads, 0 means \c WorkerPool::default_size()
+  * \return the digest, as a lower case hexadecimal string
+  * \exception OksSystem::OpenFileIssue if the file cannot be opened
+  * \exception OksSystem::ReadIssue if the file cannot be read
+  * \see OksSystem::ContentHash
+  */
+
+std::string OksSystem::File::hash(ContentHash::algorithm_t algorithm, unsigned int workers) const {
+    return ContentHash::hash(*this,algorithm,workers);
+} // hash
+
 /** Cast to size type 
   * \return the size of the file
   * \see size()
@@ -372,12 +469,15 @@ OksSystem::File::operator size_t() const {
   * \li If the path starts with ~ the username is resolved and the path starts from there
   * \li If the path starts with any other character, the working directory is prepended. 
   * 
-  * The path is then made canonical, this implies removing all ./ and ../ sequences, 
+  * In \c CANONICAL mode the path is then made canonical, this implies removing all ./ and ../ sequences, 
   * and resolving all symbolic links. 
+  * In \c LEXICAL mode ./ and ../ sequences are removed without accessing the file system 
+  * and the cached working directory is used. 
   * \param name the name of the file
+  * \param mode how the path is made canonical
   */
 
-void OksSystem::File::set_name(const std::string &name) {
+void OksSystem::File::set_name(const std::string &name, name_mode_t mode) {
     ERS_PRECONDITION(! name.empty()); 
     const char c = name[0];
     std::string long_path;
@@ -389,22 +489,26 @@ void OksSystem::File::set_name(const std::string &name) {
 	    long_path = expand_home(name); 
 	    break;
 	default:
-	    long_path = working_directory() + "/" + name;
+	    long_path = ((mode==LEXICAL) ? cached_working_directory() : working_directory()) + "/" + name;
 	    break;
     } // switch     
+    if (mode==LEXICAL) {
+	m_full_name = InternedPath(normalize(long_path));
+	return;
+    } // if
     char buffer[PATH_MAX];
     const char* result = realpath(long_path.c_str(),buffer); 
     if (result==0) { // could not resolve path 
-	m_full_name = long_path;
+	m_full_name = InternedPath(long_path);
     } else { // we could canonicalize the path 
-	m_full_name = buffer;
+	m_full_name = InternedPath(buffer);
     } // 
 } // set_name
 
 /** \return the full (absolute) path of the file */
 
 const std::string & OksSystem::File::full_name() const throw() {
-    return m_full_name;
+    return m_full_name.str();
 } // full_name
 
 /** \return the full (absolute) path of the file */
@@ -417,7 +521,7 @@ const char* OksSystem::File::c_full_name() const throw() {
 /** \return the short name of the file - that is the name of the file in its directory */
 
 std::string OksSystem::File::short_name() const throw() {
-    return short_name(m_full_name);
+    return short_name(full_name());
 } // short_name
 
 /** Finds the name of the enclosing directory 
@@ -425,22 +529,32 @@ std::string OksSystem::File::short_name() const throw() {
   */
 
 std::string OksSystem::File::parent_name() const throw() {
-  std::string::size_type size = m_full_name.size();
-  std::string::size_type slash = m_full_name.rfind(SLASH_CHAR,size-1);
+  const std::string &name = full_name();
+  std::string::size_type size = name.size();
+  std::string::size_type slash = name.rfind(SLASH_CHAR,size-1);
   if (slash==std::string::npos || slash==0) return ("/"); 
-  return m_full_name.substr(0,slash); 
+  return name.substr(0,slash); 
 } // directory
 
 /** \return the extension of the file */
 
 std::string OksSystem::File::extension() const throw() {
-    return extension(m_full_name);
+    return extension(full_name());
 } // extension
 
 int OksSystem::File::depth() const throw() {
-    return depth(m_full_name);
+    return depth(full_name());
 } // depth
 
+/** Resolves symbolic links in the path of the file.
+  * This is only needed for files built in \c LEXICAL mode. 
+  * \return a file with the canonical path, or the same path if it cannot be resolved 
+  */
+
+OksSystem::File OksSystem::File::resolve() const {
+    return File(full_name(),CANONICAL);
+} // resolve
+
 /** \return the parent directory */
 
 OksSystem::File OksSystem::File::parent() const {
@@ -448,14 +562,34 @@ OksSystem::File OksSystem::File::parent() const {
 } // parent
 
 OksSystem::File OksSystem::File::child(const std::string &name) const {
-    std::string child_name = m_full_name + "/" + name;
+    std::string child_name = full_name() + "/" + name;
     return OksSystem::File(child_name);
 } // child
 
+/** Builds a child of the current directory.
+  * In \c LEXICAL mode the child is built without any system call, 
+  * and is a symbolic link itself if the entry \c name is one. 
+  * \param name the name of the child
+  * \param mode how the path of the child is built
+  * \return the child file
+  */
+
+OksSystem::File OksSystem::File::child(const std::string &name, name_mode_t mode) const {
+    std::string child_name = full_name() + "/" + name;
+    return OksSystem::File(child_name,mode);
+} // child
+
+/** Builds a name for a temporary file in the current directory. 
+  * \deprecated the name is chosen with \c tempnam, another process can create the file 
+  * before the caller does, use \c make_temporary() which creates and opens the file at once. 
+  * \param prefix prefix of the name
+  * \return the temporary file (not created)
+  */
+
 OksSystem::File OksSystem::File::temporary(const std::string &prefix) const {
     char *tmp_name = tempnam(m_full_name.c_str(),prefix.c_str());
     if ( !tmp_name ) {
-      std::string message = "while creating a valid filename in directory " + m_full_name;
+      std::string message = "while creating a valid filename in directory " + full_name();
       throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "tempnam", message.c_str() );
     }
     OksSystem::File tmp_file(tmp_name);
@@ -463,6 +597,21 @@ OksSystem::File OksSystem::File::temporary(const std::string &prefix) const {
     return tmp_file;
 } // temporary
 
+/** Creates and opens a temporary file in the current directory, with a single system call. 
+  * By default the file is anonymous (\c O_TMPFILE), it has no name and vanishes when closed, 
+  * a named file (\c mkostemp) is created if a name is asked for or if the file system does not support anonymous files. 
+  * \param prefix prefix of the name of a named file
+  * \param named should the file have a name
+  * \param permissions permissions of the file
+  * \return the open temporary file
+  * \exception OksSystem::OpenFileIssue if the file cannot be created
+  * \see OksSystem::TemporaryFile
+  */
+
+OksSystem::TemporaryFile OksSystem::File::make_temporary(const std::string &prefix, bool named, mode_t permissions) const {
+    return TemporaryFile(*this,prefix,named,permissions);
+} // make_temporary
+
 
 /** Checks if the file exists in the fileOksSystem
   * \return \c true if the file exists, false otherwise 
@@ -476,20 +625,254 @@ bool OksSystem::File::exists() const throw() {
     return false;
 } // exists
 
-/** Extracts the mode information of the file. 
-  * This is used to determine both the file type and the file permissions 
-  * \return the mode of the file
-  * \exception OksSystem::FStatFail if fstat fails
+/** Identity of the file. 
+  * Two File objects with different paths have the same identity if they are hard links 
+  * to the same file, so this can be used to detect duplicates in sets of files. 
+  * \return the device and inode of the file
+  * \exception OksSystem::OksSystemCallIssue if stat fails
   */
 
-mode_t OksSystem::File::get_mode() const {
+OksSystem::FileId OksSystem::File::id() const {
+    return status().id();
+} // id
+
+/** Takes a snapshot of the metadata of the file.
+  * All the information is obtained with a single \c stat call, 
+  * callers needing several attributes should use this method instead of the individual accessors. 
+  * \return the status of the file
+  * \exception OksSystem::OksSystemCallIssue if stat fails
+  */
+
+OksSystem::FileStatus OksSystem::File::status() const {
     struct stat file_status;
     const int result = stat(m_full_name.c_str(),&file_status);
     if (0==result) {
-	return file_status.st_mode;
+	return FileStatus(file_status);
     } // if
-    std::string message = "on file/directory " + m_full_name;
+    std::string message = "on file/directory " + full_name();
     throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "stat", message.c_str() );
+} // status
+
+/** Takes a snapshot of the metadata of the file, without following symbolic links. 
+  * If the file is a symbolic link, the status describes the link itself. 
+  * Only files built in \c LEXICAL mode can be symbolic links, canonical paths have all links resolved. 
+  * \return the status of the file or link
+  * \exception OksSystem::OksSystemCallIssue if lstat fails
+  */
+
+OksSystem::FileStatus OksSystem::File::link_status() const {
+    struct stat file_status;
+    const int result = ::lstat(m_full_name.c_str(),&file_status);
+    if (0==result) {
+	return FileStatus(file_status);
+    } // if
+    std::string message = "on file/directory " + full_name();
+    throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "lstat", message.c_str() );
+} // link_status
+
+/** \return \c true if the file is a symbolic link 
+  * \exception OksSystem::OksSystemCallIssue if lstat fails
+  * \see link_status()
+  */
+
+bool OksSystem::File::is_symlink() const {
+    return link_status().is_symlink();
+} // is_symlink
+
+/** Reads the target of a symbolic link.
+  * The target is returned as stored in the link, it can be relative to the directory containing the link, 
+  * and it is not resolved. 
+  * \return the target of the link
+  * \exception OksSystem::OksSystemCallIssue if readlink fails, for instance if the file is not a symbolic link
+  */
+
+std::string OksSystem::File::link_target() const {
+    std::vector<char> buffer(PATH_MAX);
+    while(true) {
+	const ssize_t length = ::readlink(m_full_name.c_str(),&buffer[0],buffer.size());
+	if (length<0) {
+	    std::string message = "on file/directory " + full_name();
+	    throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "readlink", message.c_str() );
+	} // if
+	if ((size_t) length<buffer.size()) return std::string(&buffer[0],length);
+	buffer.resize(buffer.size()*2); // target may have been truncated 
+    } // while
+} // link_target
+
+/** Takes a fingerprint of the file, to detect later changes without reading it.
+  * \return the fingerprint (a single \c statx call)
+  * \exception OksSystem::OksSystemCallIssue if the file cannot be queried
+  * \see unchanged_since()
+  */
+
+OksSystem::FileFingerprint OksSystem::File::fingerprint() const {
+    return FileFingerprint(query(FileFingerprint::FIELDS));
+} // fingerprint
+
+/** Checks if the file is unchanged since a fingerprint was taken.
+  * The check is limited by the resolution of the file times: a file rewritten with the same size
+  * in the same tick of the file system clock as the fingerprint keeps the same fingerprint.
+  * Use \c FileFingerprint::racy() to know if the fingerprint was taken too early to detect such changes,
+  * or \c FingerprintCache, which applies that rule.
+  * \param fingerprint a fingerprint returned by \c fingerprint()
+  * \return \c true if the file still has the same fingerprint, \c false if it changed, was replaced or removed
+  */
+
+bool OksSystem::File::unchanged_since(const FileFingerprint &fingerprint) const throw() {
+    FileStatus file_status;
+    if (0!=query(m_full_name.c_str(),FileFingerprint::FIELDS,SYNC_AS_STAT,file_status)) return false;
+    return FileFingerprint(file_status)==fingerprint;
+} // unchanged_since
+
+/** Information about the file system containing the file.
+  * If the file does not exist yet, the file system of its parent directory is described. 
+  * \param max_age maximum age of cached information (in seconds), 0 forces a new query
+  * \return the file system information
+  * \exception OksSystem::OksSystemCallIssue if the file system cannot be queried
+  * \see FileSystemInfo::get()
+  */
+
+OksSystem::FileSystemInfo OksSystem::File::filesystem(double max_age) const {
+    if (! exists()) {
+	return FileSystemInfo::get(File(parent_name(),LEXICAL),max_age);
+    } // if
+    return FileSystemInfo::get(*this,max_age);
+} // filesystem
+
+/** Takes a partial snapshot of the metadata of the file.
+  * On Linux this uses \c statx so that only the requested fields are fetched, 
+  * on network file systems (NFS, fuse) this avoids revalidating attributes that are not needed. 
+  * The file system is free to return more fields than requested, and may not be able to return some, 
+  * the fields actually filled can be checked with \c FileStatus::has(). 
+  * If \c statx is not available, the method falls back on \c stat. 
+  * \param fields the fields needed, as a mask of \c FileStatus::field_t values
+  * \param sync whether attributes should be synchronised with the server (network file systems only)
+  * \return the status of the file
+  * \exception OksSystem::OksSystemCallIssue if statx fails
+  */
+
+OksSystem::FileStatus OksSystem::File::query(unsigned int fields, sync_t sync) const {
+    FileStatus file_status;
+    const int error = query(m_full_name.c_str(),fields,sync,file_status);
+    if (0==error) return file_status;
+    std::string message = "on file/directory " + full_name();
+    throw OksSystem::OksSystemCallIssue( ERS_HERE, error, "statx", message.c_str() );
+} // query
+
+/** Takes a partial snapshot of the metadata of a path, without throwing. 
+  * This is the implementation of the \c query() method, shared with \c stat_many(). 
+  * \param path the path of the file
+  * \param fields the fields needed, as a mask of \c FileStatus::field_t values
+  * \param sync whether attributes should be synchronised with the server
+  * \param file_status the status, filled on success
+  * \return 0 on success, the \c errno value otherwise
+  */
+
+int OksSystem::File::query(const char *path, unsigned int fields, sync_t sync, FileStatus &file_status) throw() {
+#ifdef STATX_TYPE
+    int flags = AT_STATX_SYNC_AS_STAT;
+    if (sync==SYNC_FORCE) {
+	flags = AT_STATX_FORCE_SYNC;
+    } else if (sync==SYNC_DONT) {
+	flags = AT_STATX_DONT_SYNC;
+    } 
+    struct statx x;
+    if (0==::statx(AT_FDCWD,path,flags,fields,&x)) {
+	struct stat raw;
+	memset(&raw,0,sizeof(raw));
+	raw.st_dev = makedev(x.stx_dev_major,x.stx_dev_minor);
+	raw.st_rdev = makedev(x.stx_rdev_major,x.stx_rdev_minor);
+	raw.st_ino = x.stx_ino;
+	raw.st_mode = x.stx_mode;
+	raw.st_nlink = x.stx_nlink;
+	raw.st_uid = x.stx_uid;
+	raw.st_gid = x.stx_gid;
+	raw.st_size = x.stx_size;
+	raw.st_blksize = x.stx_blksize;
+	raw.st_blocks = x.stx_blocks;
+	raw.st_atim.tv_sec = x.stx_atime.tv_sec;
+	raw.st_atim.tv_nsec = x.stx_atime.tv_nsec;
+	raw.st_mtim.tv_sec = x.stx_mtime.tv_sec;
+	raw.st_mtim.tv_nsec = x.stx_mtime.tv_nsec;
+	raw.st_ctim.tv_sec = x.stx_ctime.tv_sec;
+	raw.st_ctim.tv_nsec = x.stx_ctime.tv_nsec;
+	struct timespec birth;
+	birth.tv_sec = x.stx_btime.tv_sec;
+	birth.tv_nsec = x.stx_btime.tv_nsec;
+	file_status = FileStatus(raw,x.stx_mask & FileStatus::ALL,birth);
+	return 0;
+    } // if
+    if (errno!=ENOSYS) return errno;
+    // statx not supported by the kernel
+#else
+    (void) fields;
+    (void) sync;
+#endif
+    struct stat raw;
+    if (0!=::stat(path,&raw)) return errno;
+    file_status = FileStatus(raw);
+    return 0;
+} // query
+
+OksSystem::File::StatResult::StatResult() throw() {
+    error = 0;
+} // StatResult
+
+/** Queries the metadata of many files concurrently.
+  * Each query is a blocking \c statx call, the calls are spread over a set of threads 
+  * so that their latencies overlap, which is what matters on network file systems. 
+  * Errors do not stop the other queries and are reported per file instead of thrown.
+  * \param files pointer to the first file
+  * \param count number of files
+  * \param fields the fields needed, as a mask of \c FileStatus::field_t values
+  * \param workers maximum number of threads, 0 means \c STAT_WORKERS
+  * \param sync whether attributes should be synchronised with the server (network file systems only), as in \c query()
+  * \return one result per file, in the same order as \c files
+  */
+
+OksSystem::File::stat_list_t OksSystem::File::stat_many(const File *files, size_t count, unsigned int fields, unsigned int workers, sync_t sync) {
+    stat_list_t results(count);
+    if (0==workers) workers = STAT_WORKERS;
+    if (workers>count) workers = count;
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+	for(size_t i=next++;i<count;i=next++) {
+	    results[i].error = query(files[i].c_full_name(),fields,sync,results[i].status);
+	} // for
+    } ;
+    if (workers<=1) {
+	work();
+	return results;
+    } // if
+    WorkerPool pool(workers);
+    for(unsigned int i=0;i<workers;i++) {
+	pool.submit(work);
+    } // for
+    pool.wait();
+    return results;
+} // stat_many
+
+/** Queries the metadata of many files concurrently.
+  * \param files the files
+  * \param fields the fields needed, as a mask of \c FileStatus::field_t values
+  * \param workers maximum number of threads, 0 means \c STAT_WORKERS
+  * \param sync whether attributes should be synchronised with the server (network file systems only)
+  * \return one result per file, in the same order as \c files
+  * \see stat_many(const File*,size_t,unsigned int,unsigned int,sync_t)
+  */
+
+OksSystem::File::stat_list_t OksSystem::File::stat_many(const file_list_t &files, unsigned int fields, unsigned int workers, sync_t sync) {
+    return stat_many(files.data(),files.size(),fields,workers,sync);
+} // stat_many
+
+/** Extracts the mode information of the file. 
+  * This is used to determine both the file type and the file permissions 
+  * \return the mode of the file
+  * \exception OksSystem::FStatFail if fstat fails
+  */
+
+mode_t OksSystem::File::get_mode() const {
+    return status().mode();
 } // mode
 
 
@@ -498,8 +881,7 @@ mode_t OksSystem::File::get_mode() const {
   */
 
 mode_t OksSystem::File::permissions() const {
-    mode_t mode = get_mode();
-    return (mode & 07777);
+    return status().permissions();
 } // permissions
 
 /** \return the prettfied permissions for the file
@@ -528,11 +910,7 @@ std::string OksSystem::File::to_string(mode_t permissions) throw() {
   */
 
 size_t OksSystem::File::size() const {
-    struct stat file_status;
-    const int result = stat(m_full_name.c_str(),&file_status);
-    if (0==result) return file_status.st_size;
-    std::string message = "on file/directory " + m_full_name;
-    throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "stat", message.c_str() );
+    return status().size();
 } // size 
 
 /** \return the user-id of the owner of the file
@@ -540,11 +918,7 @@ size_t OksSystem::File::size() const {
   */
 
 uid_t OksSystem::File::owner_id() const {
-    struct stat file_status;
-    const int result = stat(m_full_name.c_str(),&file_status);
-    if (0==result) return file_status.st_uid;
-    std::string message = "on file/directory " + m_full_name;
-    throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "stat", message.c_str() );
+    return status().owner_id();
 } // owner_id
 
 OksSystem::User OksSystem::File::owner() const {
@@ -557,11 +931,7 @@ OksSystem::User OksSystem::File::owner() const {
   */
 
 gid_t OksSystem::File::group() const {
-    struct stat file_status;
-    const int result = stat(m_full_name.c_str(),&file_status);
-    if (0==result) return file_status.st_gid;
-    std::string message = "on file/directory " + m_full_name;
-    throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "stat", message.c_str() );
+    return status().group();
 } // owner
 
 
@@ -571,8 +941,7 @@ gid_t OksSystem::File::group() const {
   */
 
 bool OksSystem::File::is_regular() const {
-    const mode_t mode = get_mode();
-    return (mode & S_IFREG);
+    return status().is_regular();
 } // is_regular
 
 
@@ -582,8 +951,7 @@ bool OksSystem::File::is_regular() const {
  */
 
 bool OksSystem::File::is_directory() const {
-    const mode_t mode = get_mode();
-    return (mode & S_IFDIR);
+    return status().is_directory();
 } // is_regular
 
 /** Checks if the file a named pipe (FIFO) 
@@ -592,53 +960,277 @@ bool OksSystem::File::is_directory() const {
  */
 
 bool OksSystem::File::is_fifo() const {
-    const mode_t mode = get_mode();
-    return (mode & S_IFIFO);
+    return status().is_fifo();
 } // is_pipe
 
 
+/** Determines the type of a file.
+  * The type of special files is taken from the file status, for regular files
+  * the first bytes are read and classified with \c content_type(). 
+  * Only if the content is not recognized is the \c file command run.
+  * As with \c file, a file that cannot be read or does not exist (including a dangling symbolic link)
+  * is described, not reported as an error.
+  * \return a textual description of the type, in the same style as \c file -b
+  */
+
 std::string OksSystem::File::file_type() const {
+    struct stat status_buffer;
+    if (0!=::stat(m_full_name.c_str(),&status_buffer)) {
+	return std::string("cannot open (") + strerror(errno) + ")";
+    } // if
+    const FileStatus file_status(status_buffer);
+    if (file_status.is_directory()) return "directory";
+    if (file_status.is_fifo()) return "fifo (named pipe)";
+    if (S_ISSOCK(file_status.mode())) return "socket";
+    if (S_ISCHR(file_status.mode())) return "character special";
+    if (S_ISBLK(file_status.mode())) return "block special";
+    if (file_status.size()==0) return "empty";
+    char buffer[SNIFF_SIZE];
+    size_t length = 0;
+    try {
+	OksSystem::Descriptor fd(this,O_RDONLY | O_NOCTTY | O_CLOEXEC,0);
+	while(length<sizeof(buffer)) {
+	    const int count = fd.read(buffer+length,sizeof(buffer)-length);
+	    if (count<=0) break;
+	    length += count;
+	} // while
+	fd.close();
+    } catch (OksSystem::OpenFileIssue &ex) {
+	if (EACCES==ex.get_error()) return "regular file, no read permission";
+	return std::string("cannot open (") + strerror(ex.get_error()) + ")";
+    } // catch
+    const std::string type = content_type(buffer,length);
+    if (! type.empty()) return type;
     OksSystem::Executable file_command(FILE_COMMAND_PATH); 
     OksSystem::Executable::param_collection params;
     params.push_back("-b"); 
     params.push_back(full_name()); 
     return first_line(file_command.pipe_in(params)); 
 } // file_type
+
+namespace {
+
+    /** Reads an unsigned integer of an ELF header */
+    unsigned long elf_integer(const unsigned char *data, size_t size, bool big_endian) {
+	unsigned long value = 0;
+	for(size_t i=0;i<size;i++) {
+	    const unsigned char byte = big_endian ? data[i] : data[size-1-i];
+	    value = (value << 8) | byte;
+	} // for
+	return value;
+    } // elf_integer
+
+    /** Describes an ELF header, in the same style as the file command */
+    std::string elf_type(const unsigned char *data, size_t length) {
+	if (length<20) return "ELF";
+	const bool is_64 = (data[4]==2);
+	const bool big_endian = (data[5]==2);
+	std::ostringstream type;
+	type << "ELF " << (is_64 ? "64-bit " : "32-bit ") << (big_endian ? "MSB " : "LSB ");
+	const unsigned long e_type = elf_integer(data+16,2,big_endian);
+	bool interpreter = false;
+	const size_t header_size = is_64 ? 64 : 52;
+	if (e_type==3 && length>=header_size) { // position independent executable or shared object ?
+	    const unsigned long phoff = is_64 ? elf_integer(data+32,8,big_endian) : elf_integer(data+28,4,big_endian);
+	    const unsigned long phentsize = elf_integer(data+(is_64 ? 54 : 42),2,big_endian);
+	    const unsigned long phnum = elf_integer(data+(is_64 ? 56 : 44),2,big_endian);
+	    // only the entries entirely in the buffer are read, the bounds are checked without additions that could wrap
+	    const unsigned long available = (phoff<=length && phentsize>=4) ? (length-phoff)/phentsize : 0;
+	    for(unsigned long i=0;i<phnum && i<available;i++) {
+		const unsigned long offset = phoff + i*phentsize;
+		if (elf_integer(data+offset,4,big_endian)==3) interpreter = true; // PT_INTERP
+	    } // for
+	} // if
+	switch (e_type) {
+	    case 1: type << "relocatable"; break;
+	    case 2: type << "executable"; break;
+	    case 3: type << (interpreter ? "pie executable" : "shared object"); break;
+	    case 4: type << "core file"; break;
+	    default: type << "unknown type"; break;
+	} // switch
+	switch (elf_integer(data+18,2,big_endian)) {
+	    case 3:   type << ", Intel 80386"; break;
+	    case 8:   type << ", MIPS"; break;
+	    case 20:  type << ", PowerPC"; break;
+	    case 21:  type << ", 64-bit PowerPC"; break;
+	    case 22:  type << ", IBM S/390"; break;
+	    case 40:  type << ", ARM"; break;
+	    case 62:  type << ", x86-64"; break;
+	    case 183: type << ", ARM aarch64"; break;
+	    case 243: type << ", UCB RISC-V"; break;
+	    default: break;
+	} // switch
+	return type.str();
+    } // elf_type
+
+    /** Describes a script from its interpreter line, in the same style as the file command */
+    std::string script_type(const char *data, size_t length) {
+	const char *end = (const char *) memchr(data,'\n',length);
+	std::string line(data+2,end ? end : data+length);
+	std::istringstream words(line);
+	std::string interpreter;
+	words >> interpreter;
+	interpreter = OksSystem::File::short_name(interpreter);
+	if (interpreter=="env") {
+	    words >> interpreter;
+	} // if
+	std::string name;
+	if (interpreter=="sh") {
+	    name = "POSIX shell";
+	} else if (interpreter=="bash") {
+	    name = "Bourne-Again shell";
+	} else if (interpreter.compare(0,6,"python")==0) {
+	    name = "Python";
+	} else if (interpreter.compare(0,4,"perl")==0) {
+	    name = "Perl";
+	} else if (interpreter=="tcsh" || interpreter=="csh") {
+	    name = "C shell";
+	} else {
+	    const std::string::size_type start = line.find_first_not_of(" \t\r");
+	    if (std::string::npos==start) return "script";
+	    name = "a " + line.substr(start);
+	} // if
+	return name + " script";
+    } // script_type
+
+    /** Checks if a buffer contains text 
+      * \return 0 for binary, 1 for ASCII text, 2 for UTF-8 text 
+      */
+    int text_kind(const unsigned char *data, size_t length) {
+	int kind = 1;
+	for(size_t i=0;i<length;i++) {
+	    const unsigned char c = data[i];
+	    if (c>=0x20 && c<0x7f) continue;
+	    if (c=='\n' || c=='\r' || c=='\t' || c=='\f' || c=='\b' || c==0x1b) continue;
+	    if (c<0x80) return 0;
+	    size_t follow = 0;
+	    if ((c & 0xe0)==0xc0) {
+		follow = 1;
+	    } else if ((c & 0xf0)==0xe0) {
+		follow = 2;
+	    } else if ((c & 0xf8)==0xf0) {
+		follow = 3;
+	    } else {
+		return 0;
+	    } // if
+	    for(size_t k=1;k<=follow;k++) {
+		if (i+k>=length) return 2; // sequence cut by the end of the buffer
+		if ((data[i+k] & 0xc0)!=0x80) return 0;
+	    } // for
+	    i += follow;
+	    kind = 2;
+	} // for
+	return kind;
+    } // text_kind
+
+} // anonymous namespace
+
+/** Classifies the beginning of a file. 
+  * This recognizes ELF objects (with bitness and architecture), scripts, XML and JSON documents, 
+  * gzip, bzip2, xz and zstd compressed data and text. 
+  * \param data the first bytes of the file
+  * \param length the number of bytes available
+  * \return a textual description of the type, in the same style as \c file -b, or an empty string 
+  *         if the content is not recognized 
+  */
+
+std::string OksSystem::File::content_type(const void *data, size_t length) {
+    const unsigned char *bytes = (const unsigned char *) data;
+    if (length==0) return "empty";
+    if (length>=4 && memcmp(bytes,"\x7f" "ELF",4)==0) return elf_type(bytes,length);
+    if (length>=2 && bytes[0]==0x1f && bytes[1]==0x8b) return "gzip compressed data";
+    if (length>=4 && memcmp(bytes,"\x28\xb5\x2f\xfd",4)==0) return "Zstandard compressed data";
+    if (length>=6 && memcmp(bytes,"\xfd" "7zXZ\0",6)==0) return "XZ compressed data";
+    if (length>=3 && memcmp(bytes,"BZh",3)==0) return "bzip2 compressed data";
+    const int kind = text_kind(bytes,length);
+    if (kind==0) return std::string();
+    const std::string text = (kind==1) ? "ASCII text" : "Unicode text, UTF-8 text";
+    const char *chars = (const char *) data;
+    if (length>=2 && chars[0]=='#' && chars[1]=='!') return script_type(chars,length) + ", " + text + " executable";
+    size_t start = 0;
+    if (length>=3 && memcmp(bytes,"\xef\xbb\xbf",3)==0) start = 3; // byte order mark
+    while(start<length && isspace(bytes[start])) start++;
+    if (length-start>=5 && memcmp(chars+start,"<?xml",5)==0) {
+	std::string version = "1.0";
+	const std::string header(chars+start,length-start);
+	const std::string::size_type v = header.find("version=");
+	if (v!=std::string::npos && v+9<header.size()) {
+	    const char quote = header[v+8];
+	    const std::string::size_type close = header.find(quote,v+9);
+	    if (close!=std::string::npos) version = header.substr(v+9,close-v-9);
+	} // if
+	return "XML " + version + " document, " + text;
+    } // if
+    if (start<length && (chars[start]=='{' || chars[start]=='[')) {
+	size_t next = start+1;
+	while(next<length && isspace(bytes[next])) next++;
+	if (next<length && (chars[next]=='"' || chars[next]=='}' || chars[next]==']' || chars[next]=='{' || chars[next]=='[' 
+	    || isdigit(bytes[next]) || chars[next]=='-' || chars[next]=='t' || chars[next]=='f' || chars[next]=='n')) {
+	    return "JSON text data";
+	} // if
+    } // if
+    return text;
+} // content_type
     
 /** Builds a vector containing all the files contained in a directory 
   * \return a vector of files contained in the directory 
-  * \exception OksSystem::OpenFail if the directory could not be openend
-  * \exception OksSystem::CloseFail if the directory cannot be closed 
+  * \exception OksSystem::OksSystemCallIssue if the directory could not be read
+  * \note each file is canonicalized, use \c entries() or OksSystem::DirectoryIterator 
+  *       if only names and types are needed
   */
 
 OksSystem::File::file_list_t OksSystem::File::directory() const {
     file_list_t file_vector;
-    DIR* directory_ptr = opendir(m_full_name.c_str());
-    if (! directory_ptr) {
-      std::string message = "on directory " + m_full_name;
-      throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "opendir", message.c_str() );
-    }
-    while(true) {
-	struct dirent* directory_entry = readdir(directory_ptr); 
-	if (directory_entry) {
-	    const std::string name = directory_entry->d_name;
-	    if ((name!=".") && (name!="..")) {
-		std::string path = m_full_name + "/" + name;
-		OksSystem::File file(path); 
-		file_vector.push_back(file);
-	    } // if
-	} else {
-	    break;
-	} // if / else
-    } // while
-    int status = closedir(directory_ptr);
-    if (status<0) {
-      std::string message = "on directory " + m_full_name;
-      throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "closedir", message.c_str() );
-    }
+    DirectoryIterator listing(*this);
+    for(const DirectoryEntry *entry = listing.next(); entry; entry = listing.next()) {
+	file_vector.push_back(entry->file());
+    } // for
+    listing.close();
     return file_vector;
 } // directory
 
+/** Builds a vector containing the raw entries of a directory.
+  * Entries are read in large batches with \c getdents64, their name, inode and type 
+  * come directly from the kernel and no path is canonicalized. 
+  * \return a vector of entries contained in the directory (without . and ..)
+  * \exception OksSystem::OksSystemCallIssue if the directory could not be read
+  * \see OksSystem::DirectoryIterator to stream the entries instead of building a vector
+  */
+
+OksSystem::File::entry_list_t OksSystem::File::entries() const {
+    entry_list_t entry_vector;
+    DirectoryIterator listing(*this);
+    for(const DirectoryEntry *entry = listing.next(); entry; entry = listing.next()) {
+	entry_vector.push_back(*entry);
+    } // for
+    listing.close();
+    return entry_vector;
+} // entries
+
+/** Computes the space used by the file, or by the directory tree, like \c du. 
+  * Directories that cannot be read are skipped: if \c DiskUsage::errors() is not zero, the totals are partial.
+  * \param workers number of threads, 0 means one per hardware thread
+  * \return the usage, in total and for each entry of the directory
+  * \exception OksSystem::OksSystemCallIssue if the file cannot be queried
+  * \see OksSystem::DiskUsage
+  */
+
+OksSystem::DiskUsage OksSystem::File::disk_usage(unsigned int workers) const {
+    return DiskUsage(*this,workers);
+} // disk_usage
+
+/** Searches the directory tree for entries whose name matches a glob pattern.
+  * Symbolic links are not followed. For more selective searches, see OksSystem::TreeWalker.
+  * \param pattern the glob pattern, for instance \c "*.xml"
+  * \param workers number of threads, 0 means one per hardware thread
+  * \return the entries, in no particular order
+  * \exception OksSystem::OksSystemCallIssue if a directory cannot be read
+  */
+
+OksSystem::File::entry_list_t OksSystem::File::find(const std::string &pattern, unsigned int workers) const {
+    return TreeWalker(workers).name(pattern).find(*this);
+} // find
+
 /** Unlinks (i.e deletes) a file. 
   * \exception ers::IOIssue if an error occurs or the file does not exist 
   */
@@ -652,31 +1244,38 @@ void OksSystem::File::unlink() const {
 void OksSystem::File::rmdir() const {
     const int result = ::rmdir(m_full_name.c_str());
     if (0==result) return;
-    std::string message = "on directory " + m_full_name;
+    std::string message = "on directory " + full_name();
     throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "rmdir", message.c_str() ); 
 } // rmdir
 
 
 /** Recursively delete files and directories.
   * If the file is a directory, all its child are deleted recursively. 
-  * \exception OksSystem::UnlinkFail if \c unlink fails 
+  * Symbolic links inside the directory are deleted, not followed. 
+  * This is done in the calling thread, see \c remove_tree() for parallel deletion. 
+  * \exception OksSystem::RemoveFileIssue if \c unlink fails 
+  * \exception OksSystem::OksSystemCallIssue if a directory cannot be read or removed
   */
 
 void OksSystem::File::remove() const {
-    if (is_directory()) {
-	file_list_t childs = directory(); 
-	for (file_list_t::const_iterator p=childs.begin();p!=childs.end();p++) {
-	    const File f = *p;
-	    if(f.exists()) {
-	      f.remove(); 
-	    }
-	} // for
-	rmdir();
-    } else {
-	unlink(); 
-    } 
+    remove_tree(1); 
 } // remove
 
+/** Recursively delete files and directories using several threads.
+  * Directories are opened relative to their parent and entries removed with \c unlinkat, 
+  * subtrees are spread over a pool of worker threads. 
+  * \param workers number of threads, 0 means one per hardware thread 
+  * \return the number of files, directories and bytes removed and the time spent in each phase
+  * \exception OksSystem::RemoveFileIssue if \c unlink fails 
+  * \exception OksSystem::OksSystemCallIssue if a directory cannot be read or removed
+  * \see OksSystem::TreeRemover
+  */
+
+OksSystem::TreeRemover::Statistics OksSystem::File::remove_tree(unsigned int workers) const {
+    const TreeRemover remover(workers);
+    return remover.remove(*this);
+} // remove_tree
+
 
 /** Renames or moves a file. 
   * \param new_name the new name of the file 
@@ -691,6 +1290,79 @@ void OksSystem::File::rename(const File &other) const {
     throw OksSystem::RenameFileIssue( ERS_HERE, errno, source, dest );
 } // rename
 
+/** Copies the file.
+  * The data is copied inside the kernel when possible (reflink, \c copy_file_range or \c sendfile), 
+  * holes are preserved and the copy gets the permissions of the file. 
+  * \param destination the copy, it is created or replaced, and left untouched if the copy fails
+  * \param progress function called as the copy progresses, can be empty
+  * \return statistics about the copy
+  * \exception OksSystem::OpenFileIssue if a file cannot be opened
+  * \exception OksSystem::OksSystemCallIssue if the copy fails
+  * \exception OksSystem::RenameFileIssue if the destination cannot be replaced
+  * \see OksSystem::FileCopier
+  */
+
+OksSystem::FileCopier::Statistics OksSystem::File::copy_to(const File &destination, const FileCopier::progress_t &progress) const {
+    return FileCopier(progress).copy(*this,destination);
+} // copy_to
+
+/** Moves the file.
+  * The file is renamed if possible, if the destination is on another file system 
+  * the file is copied with \c copy_to() and then unlinked. 
+  * A symbolic link is moved as a link: it is created again with the same target, it is never followed.
+  * Directories can only be moved within a file system.
+  * \param destination the new name of the file
+  * \param progress function called as the copy progresses, if a copy is needed, can be empty
+  * \return statistics about the copy, with \c data_bytes set to 0 if the file was simply renamed
+  * \exception OksSystem::RenameFileIssue if the file cannot be renamed
+  * \exception OksSystem::OpenFileIssue if a file cannot be opened for the copy
+  * \exception OksSystem::OksSystemCallIssue if the copy fails
+  * \exception OksSystem::RemoveFileIssue if the file cannot be removed after the copy 
+  */
+
+OksSystem::FileCopier::Statistics OksSystem::File::move_to(const File &destination, const FileCopier::progress_t &progress) const {
+    if (0==::rename(c_full_name(),destination.c_full_name())) {
+	FileCopier::Statistics statistics;
+	statistics.bytes = size_t(destination);
+	return statistics;
+    } // if
+    const int error = errno;
+    if (error==EXDEV && is_symlink()) {
+	move_link_to(destination);
+	return FileCopier::Statistics();
+    } // if
+    if (error!=EXDEV || is_directory()) {
+	throw OksSystem::RenameFileIssue( ERS_HERE, error, c_full_name(), destination.c_full_name() );
+    } // if
+    const FileCopier::Statistics statistics = copy_to(destination,progress);
+    unlink();
+    return statistics;
+} // move_to
+
+/** Moves a symbolic link to another file system.
+  * The link is created under a temporary name in the directory of the destination and renamed over it,
+  * so that an existing destination is replaced as \c rename would do, then the original link is removed.
+  * \param destination the new name of the link
+  * \exception OksSystem::OksSystemCallIssue if the link cannot be read or created
+  * \exception OksSystem::RenameFileIssue if the destination cannot be replaced
+  * \exception OksSystem::RemoveFileIssue if the original link cannot be removed
+  */
+
+void OksSystem::File::move_link_to(const File &destination) const {
+    const std::string target = link_target();
+    const std::string temporary = destination.parent_name() + "/." + destination.short_name() + "." + std::to_string(::getpid()) + ".link";
+    if (0!=::symlink(target.c_str(),temporary.c_str())) {
+	std::string message = "on file " + temporary;
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "symlink", message.c_str() );
+    } // if
+    if (0!=::rename(temporary.c_str(),destination.c_full_name())) {
+	const int error = errno;
+	::unlink(temporary.c_str());
+	throw OksSystem::RenameFileIssue( ERS_HERE, error, temporary.c_str(), destination.c_full_name() );
+    } // if
+    unlink();
+} // move_link_to
+
 /** Sets the permissions of the file 
   * \param permissions the new permissions
   * \exception ers::IOIssue if an error occurs or the file does not exist 
@@ -702,7 +1374,7 @@ void OksSystem::File::permissions(mode_t perm) const {
     if (0==result) {
       return;
     }
-    std::string message = "on file/directory " + m_full_name;
+    std::string message = "on file/directory " + full_name();
     throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "chmod", message.c_str());
   }
 } // permissions
@@ -725,7 +1397,7 @@ void OksSystem::File::make_dir(mode_t perm) const {
 	permissions(perm);
       }
       catch (OksSystem::OksSystemCallIssue &e){
-	std::string message = "on directory " + m_full_name;
+	std::string message = "on directory " + full_name();
 	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "mkdir -> chmod", message.c_str() ); 
       }
       return;
@@ -741,7 +1413,7 @@ void OksSystem::File::make_dir(mode_t perm) const {
 	  return;
 	} // is directory
       } else { // exists
-	std::string message = "on directory " + m_full_name;
+	std::string message = "on directory " + full_name();
 	throw OksSystem::OksSystemCallIssue(ERS_HERE, mkdir_error, "mkdir", message.c_str()); 
       }
     }
@@ -750,23 +1422,109 @@ void OksSystem::File::make_dir(mode_t perm) const {
 
 /** Builds a full path. 
   * The current object is taken as the name of a directory to create. 
-  * This method creates all the parent directories as needed
+  * This method creates all the parent directories as needed. 
+  * The path is not canonicalized again: the deepest existing directory is found by 
+  * trying \c mkdir on the path and its ancestors (\c EEXIST being the normal case), 
+  * then the missing components are created with \c mkdirat relative to it. 
+  * Permissions are only changed when the process umask did not give the requested ones. 
   * \param permissions the permissions to associate with the directory
   * \note If parent directories are created, their permissions will be those
   *       defined in \c permissions ORed with 0700. 
   *       This is needed to ensure we can actually write into the directories 
   *       we create. 
+  * \exception OksSystem::OksSystemCallIssue if a directory cannot be created
   */
 
 void OksSystem::File::make_path(mode_t perm) const { 
-    const File father = parent(); 
-    if (! father.exists()) {
-	mode_t father_permission = perm | S_IRWXU;// we need rights to write sons
-	father.make_path(father_permission); 
+    const mode_t father_permission = perm | S_IRWXU; // we need rights to write sons
+    const std::string &path = full_name();
+    std::vector<std::string::size_type> starts;
+    std::vector<std::string::size_type> ends;
+    for(std::string::size_type pos = 0; pos<path.size();) {
+	if (path[pos]==SLASH_CHAR) {
+	    pos++;
+	    continue;
+	} // if
+	std::string::size_type slash = path.find(SLASH_CHAR,pos);
+	if (slash==std::string::npos) slash = path.size();
+	starts.push_back(pos);
+	ends.push_back(slash);
+	pos = slash;
+    } // for
+    const size_t count = ends.size();
+    if (0==count) return; // root directory 
+    // Walk up until a directory exists or can be created
+    size_t existing = count;
+    bool created = false;
+    for(;existing>0;existing--) {
+	const std::string prefix = path.substr(0,ends[existing-1]);
+	const mode_t mode = (existing==count) ? perm : father_permission;
+	if (0==::mkdir(prefix.c_str(),mode)) {
+	    created = true;
+	    fix_permissions(AT_FDCWD,prefix.c_str(),mode,true);
+	    break;
+	} // if
+	if (errno==EEXIST) break;
+	if (errno!=ENOENT) {
+	    std::string message = "on directory " + prefix;
+	    throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "mkdir", message.c_str() ); 
+	} // if
+    } // for
+    if (existing==count) {
+	if (! created) { // already exists we attempt a chmod
+	    fix_permissions(AT_FDCWD,path.c_str(),perm,false);
+	} // if
+	return;
+    } // if
+    // Create the missing components relative to the deepest existing directory
+    const std::string base = (existing>0) ? path.substr(0,ends[existing-1]) : std::string("/");
+    const int base_fd = ::open(base.c_str(),O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (base_fd<0) {
+	std::string message = "on directory " + base;
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "open", message.c_str() ); 
     } // if
-    make_dir(perm); 
+    try {
+	for(size_t i=existing;i<count;i++) {
+	    const std::string relative = path.substr(starts[existing],ends[i]-starts[existing]);
+	    const mode_t mode = (i+1==count) ? perm : father_permission;
+	    if (0==::mkdirat(base_fd,relative.c_str(),mode)) {
+		fix_permissions(base_fd,relative.c_str(),mode,true);
+	    } else if (errno!=EEXIST) { // somebody else might be creating the same path 
+		std::string message = "on directory " + path.substr(0,ends[i]);
+		throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "mkdir", message.c_str() ); 
+	    } // if
+	} // for
+    } catch (OksSystem::OksSystemCallIssue &) {
+	::close(base_fd);
+	throw;
+    } // catch
+    ::close(base_fd);
 } // makepath
 
+/** Sets the permissions of a directory if they are not the requested ones.
+  * \param dir_fd descriptor of the directory \c name is relative to, or \c AT_FDCWD
+  * \param name name of the directory
+  * \param perm the requested permissions
+  * \param created was the directory just created, if not errors are ignored and 
+  *        only directories are changed (same behaviour as \c make_dir())
+  * \exception OksSystem::OksSystemCallIssue if permissions of a created directory cannot be set
+  */
+
+void OksSystem::File::fix_permissions(int dir_fd, const char *name, mode_t perm, bool created) {
+    struct stat dir_status;
+    const int result = ::fstatat(dir_fd,name,&dir_status,0);
+    if (0!=result) {
+	if (! created) return;
+    } else {
+	if (! S_ISDIR(dir_status.st_mode)) return;
+	if ((dir_status.st_mode & 07777)==perm) return;
+	if (0==::fchmodat(dir_fd,name,perm,0)) return;
+	if (! created) return;
+    } // if
+    std::string message = "on directory " + std::string(name);
+    throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "mkdir -> chmod", message.c_str() ); 
+} // fix_permissions
+
 /** Makes sure that the path for a file exists 
   * This is done by calling \c make_path on the parent directory 
   * \param permissions permissions used to create directories
@@ -799,7 +1557,7 @@ void OksSystem::File::make_fifo(mode_t perm) const {
       permissions(perm);
       return;
     } 
-    std::string message = "while creating FIFO " + m_full_name;
+    std::string message = "while creating FIFO " + full_name();
     throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "mkfifo", message.c_str() ); 
 } // makefifo
     
@@ -822,6 +1580,141 @@ std::istream* OksSystem::File::input() const {
     } // catch
 } // std::istream*
 
+/** Gives the whole content of the file as one contiguous block of memory. 
+  * This is much cheaper than reading the file through \c input(): small files are read
+  * with a single system call, large files are mapped in memory. 
+  * \param threshold size from which the file is mapped instead of read
+  * \return the content of the file
+  * \exception OksSystem::OpenFileIssue if the file cannot be opened 
+  * \exception OksSystem::ReadIssue if the file cannot be read 
+  * \see OksSystem::FileContent
+  */
+
+OksSystem::FileContent OksSystem::File::content(size_t threshold) const {
+    return FileContent(*this,threshold);
+} // content
+
+namespace {
+
+    /** Allocates disk space after the end of an open file, see \c OksSystem::File::reserve() */
+    void reserve_descriptor(const OksSystem::File &file, int fd, size_t bytes) {
+	if (0==bytes) return;
+	struct stat file_status;
+	const off_t offset = (0==::fstat(fd,&file_status)) ? file_status.st_size : 0;
+	if (0==::fallocate(fd,FALLOC_FL_KEEP_SIZE,offset,bytes)) return;
+	const int error = errno;
+	if (error==ENOSPC || error==EDQUOT) {
+	    throw OksSystem::NoSpaceIssue( ERS_HERE, error, file.c_full_name(), bytes, file.filesystem(0).available_bytes() );
+	} // if
+	if (error==EOPNOTSUPP || error==ENOSYS) {
+	    const OksSystem::FileSystemInfo info = file.filesystem(0);
+	    if (info.has_space(bytes)) return;
+	    throw OksSystem::NoSpaceIssue( ERS_HERE, ENOSPC, file.c_full_name(), bytes, info.available_bytes() );
+	} // if
+	std::string message = "on file " + file.full_name();
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, error, "fallocate", message.c_str() );
+    } // reserve_descriptor
+
+    /** Releases the disk space allocated after the end of an open file, see \c OksSystem::File::unreserve() */
+    void unreserve_descriptor(const OksSystem::File &file, int fd) {
+	struct stat file_status;
+	int result = ::fstat(fd,&file_status);
+	if (0==result) result = ::ftruncate(fd,file_status.st_size);
+	if (0!=result) {
+	    std::string message = "on file " + file.full_name();
+	    throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "ftruncate", message.c_str() );
+	} // if
+    } // unreserve_descriptor
+
+    /** Output stream on a descriptor, releasing the space reserved and not used when it is destroyed */
+    class ReservedOutputStream : public OksSystem::DescriptorOutputStream {
+    protected:
+	OksSystem::File m_file ;
+    public:
+	ReservedOutputStream(const OksSystem::File &file, OksSystem::Descriptor *descriptor) : OksSystem::DescriptorOutputStream(descriptor), m_file(file) {}
+	virtual ~ReservedOutputStream() {
+	    if (fd()<0) return; // closed by the caller
+	    try {
+		flush();
+	    } catch (ers::Issue &ex) {
+		ers::warning(ex);
+	    } catch (...) {
+		// the stream is bad, the error was reported when writing
+	    } // catch
+	    try {
+		unreserve_descriptor(m_file,fd());
+	    } catch (ers::Issue &ex) {
+		ers::warning(ex);
+	    } // catch
+	} // ~ReservedOutputStream
+    } ; // ReservedOutputStream
+
+} // anonymous namespace
+
+/** Allocates disk space for data to be written at the end of the file. 
+  * The size of the file is not changed, but the blocks are allocated, so that later writes 
+  * cannot fail for lack of space and the file is less fragmented. 
+  * On file systems that do not support preallocation, the free space is checked instead. 
+  * The blocks stay allocated after the file is closed, even if less data is written:
+  * the unused part must then be released with \c unreserve().
+  * \param bytes the number of bytes to reserve after the current end of the file
+  * \exception OksSystem::NoSpaceIssue if there is not enough space on the file system
+  * \exception OksSystem::OpenFileIssue if the file cannot be opened 
+  * \exception OksSystem::OksSystemCallIssue if the allocation fails for another reason
+  */
+
+void OksSystem::File::reserve(size_t bytes) const {
+    if (0==bytes) return;
+    Descriptor fd(this,O_WRONLY | O_CLOEXEC,0);
+    reserve_descriptor(*this,fd,bytes);
+} // reserve
+
+/** Releases the disk space allocated beyond the end of the file, 
+  * by \c reserve() for data that was finally not written. 
+  * The file is truncated to its own size, which frees the blocks past its end. 
+  * \exception OksSystem::OpenFileIssue if the file cannot be opened 
+  * \exception OksSystem::OksSystemCallIssue if the space cannot be released
+  */
+
+void OksSystem::File::unreserve() const {
+    Descriptor fd(this,O_WRONLY | O_CLOEXEC,0);
+    unreserve_descriptor(*this,fd);
+} // unreserve
+
+/** Conversion into an output stream pointer, with disk space reserved for the data.
+  * The free space of the file system is first checked with the cached file system information. 
+  * The file is then opened without being truncated and the space is allocated on it, 
+  * an existing file is only truncated (when not appending) once the allocation succeeded, 
+  * so it is kept if the data cannot fit, including because of a quota. 
+  * The truncation frees the blocks allocated, they are then allocated again, 
+  * which can only fail if another writer took the space meanwhile.
+  * The stream writes directly to the descriptor (see OksSystem::DescriptorOutputStream), 
+  * when it is deleted, the space reserved and not used is released.
+  * \param append is the file opened in append mode 
+  * \param reserve number of bytes that will be written
+  * \return a dynamically allocated output stream 
+  * \exception OksSystem::NoSpaceIssue if there is not enough space on the file system
+  * \exception ers::IOIssue if an error occurs
+  */
+
+std::ostream* OksSystem::File::output(bool append, size_t reserve) const {
+    if (0==reserve) return output(append);
+    const FileSystemInfo info = filesystem();
+    if (! info.has_space(reserve)) {
+	throw OksSystem::NoSpaceIssue( ERS_HERE, ENOSPC, m_full_name.c_str(), reserve, info.available_bytes() );
+    } // if
+    std::unique_ptr<Descriptor> fd(new Descriptor(this,O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : 0),0666));
+    reserve_descriptor(*this,*fd,reserve);
+    if (! append) {
+	if (0!=::ftruncate(*fd,0)) {
+	    std::string message = "on file " + full_name();
+	    throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "ftruncate", message.c_str() );
+	} // if
+	reserve_descriptor(*this,*fd,reserve);
+    } // if
+    return new ReservedOutputStream(*this,fd.release());
+} // std::ostream*
+
 /** Conversion into an output stream pointer
  * This actually creates a new output stream that writes to the file. 
  * \return a dynamically allocated output stream 
@@ -843,6 +1736,68 @@ std::ostream* OksSystem::File::output(bool append) const {
     } // catch
 } // std::ostream*
 
+/** Input stream reading the file directly through its descriptor. 
+  * Unlike \c input(), the buffer size and the open flags can be chosen, 
+  * the stream only throws for I/O errors, not at the end of the file. 
+  * \param options buffer size and open flags
+  * \return a dynamically allocated input stream 
+  * \exception OksSystem::OpenFileIssue if the file cannot be opened 
+  * \see OksSystem::DescriptorStreamBuf
+  */
+
+OksSystem::DescriptorInputStream* OksSystem::File::input(const DescriptorStreamBuf::Options &options) const {
+    const int fd = DescriptorStreamBuf::open(*this,O_RDONLY,0,options);
+    return new DescriptorInputStream(new Descriptor(fd,full_name()),options);
+} // input
+
+/** Output stream writing to the file directly through its descriptor. 
+  * Unlike \c output(), the buffer size and the open flags can be chosen. 
+  * The stream should be closed with \c DescriptorOutputStream::close() to get the errors of the last write,
+  * if it is simply deleted, they are only reported as warnings. 
+  * \param append is the file opened in append mode 
+  * \param options buffer size and open flags
+  * \return a dynamically allocated output stream 
+  * \exception OksSystem::OpenFileIssue if the file cannot be opened 
+  * \see OksSystem::DescriptorStreamBuf
+  */
+
+OksSystem::DescriptorOutputStream* OksSystem::File::output(bool append, const DescriptorStreamBuf::Options &options) const {
+    const int flags = O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC);
+    const int fd = DescriptorStreamBuf::open(*this,flags,0666,options);
+    return new DescriptorOutputStream(new Descriptor(fd,full_name()),options);
+} // output
+
+/** Builds a writer that replaces the content of the file atomically. 
+  * Unlike \c output(), which truncates the file in place, readers never see a partially written file. 
+  * \param permissions permissions of the new file, by default those of the file it replaces
+  * \param batch if not null, the flush of the directory is deferred to this batch
+  * \return the writer, the file is replaced by \c AtomicWriter::commit()
+  * \exception OksSystem::OpenFileIssue if the temporary file cannot be created
+  * \see OksSystem::AtomicWriter
+  */
+
+OksSystem::AtomicWriter OksSystem::File::atomic_writer(mode_t permissions, AtomicWriter::SyncBatch *batch) const {
+    return AtomicWriter(*this,permissions,batch);
+} // atomic_writer
+
+/** Replaces the content of the file atomically and durably. 
+  * \param data the new content
+  * \param size size of the new content
+  * \param permissions permissions of the new file, by default those of the file it replaces
+  * \param batch if not null, the flush of the directory is deferred to this batch
+  * \see OksSystem::AtomicWriter
+  */
+
+void OksSystem::File::atomic_write(const void *data, size_t size, mode_t permissions, AtomicWriter::SyncBatch *batch) const {
+    AtomicWriter writer(*this,permissions,batch);
+    writer.write(data,size);
+    writer.commit();
+} // atomic_write
+
+void OksSystem::File::atomic_write(std::string_view data, mode_t permissions, AtomicWriter::SyncBatch *batch) const {
+    atomic_write(data.data(),data.size(),permissions,batch);
+} // atomic_write
+
 /** Stream a file object into a STL stream. 
   * \param stream destination stream.
   * \param file the file to write
@@ -0,0 +1,141 @@
+/*
+ *  FileContent.cxx
+ *  OksSystem
+ *
+ *  Read-only view of the whole content of a file.
+ *
+ */
+
+#include <algorithm>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "okssystem/File.hpp"
+#include "okssystem/FileContent.hpp"
+#include "okssystem/exceptions.hpp"
+
+const size_t OksSystem::FileContent::MAP_THRESHOLD = 256*1024;
+
+/** Reads or maps the content of a file.
+  * The size of the file is obtained with \c fstat on the opened file,
+  * files smaller than \c threshold are read, others are mapped.
+  * \param file the file
+  * \param threshold size from which the file is mapped, it is rounded up to the page size
+  * \exception OksSystem::OpenFileIssue if the file cannot be opened
+  * \exception OksSystem::ReadIssue if the file cannot be read
+  * \exception OksSystem::OksSystemCallIssue if the file cannot be mapped
+  */
+
+OksSystem::FileContent::FileContent(const File &file, size_t threshold) {
+    m_map = 0;
+    m_map_size = 0;
+    m_data = 0;
+    m_size = 0;
+    const std::string &name = file.full_name();
+    const int fd = ::open(name.c_str(),O_RDONLY | O_CLOEXEC);
+    if (fd<0) {
+	throw OksSystem::OpenFileIssue( ERS_HERE, errno, name.c_str() );
+    } // if
+    struct stat status;
+    if (0!=::fstat(fd,&status)) {
+	const int error = errno;
+	::close(fd);
+	std::string message = "on file " + name;
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, error, "fstat", message.c_str() );
+    } // if
+    const size_t page_size = ::getpagesize();
+    threshold = ((threshold+page_size-1)/page_size)*page_size;
+    const size_t size = status.st_size;
+    try {
+	if (S_ISREG(status.st_mode) && size>0 && size>=threshold) {
+	    map(fd,size,name);
+	} else {
+	    read(fd,size,name);
+	} // if
+    } catch (ers::Issue &) {
+	::close(fd);
+	throw;
+    } // catch
+    ::close(fd); // a mapping stays valid after its descriptor is closed
+} // FileContent
+
+/** Move constructor, the content is taken over without copy */
+
+OksSystem::FileContent::FileContent(FileContent &&other) throw() : m_buffer(std::move(other.m_buffer)), m_map(other.m_map), m_map_size(other.m_map_size) {
+    m_data = m_map ? other.m_data : m_buffer.data();
+    m_size = other.m_size;
+    other.m_map = 0;
+    other.m_map_size = 0;
+    other.m_buffer.clear();
+    other.m_data = other.m_buffer.data();
+    other.m_size = 0;
+} // FileContent
+
+OksSystem::FileContent::~FileContent() {
+    release();
+} // ~FileContent
+
+/** Reads the file into the buffer.
+  * The buffer is one byte larger than the expected size, so that a file of the expected size
+  * is read with one call, and a file that grew or has no known size (\c /proc) is read until the end.
+  * \param fd descriptor of the file
+  * \param size expected size of the file
+  * \param name name of the file, for error messages
+  */
+
+void OksSystem::FileContent::read(int fd, size_t size, const std::string &name) {
+    m_buffer.resize(size+1);
+    size_t used = 0;
+    while(true) {
+	if (used==m_buffer.size()) {
+	    m_buffer.resize(std::max(2*m_buffer.size(),(size_t) ::getpagesize()));
+	} // if
+	const ssize_t n = ::read(fd,&m_buffer[used],m_buffer.size()-used);
+	if (n<0) {
+	    if (EINTR==errno) continue;
+	    throw OksSystem::ReadIssue( ERS_HERE, errno, name.c_str() );
+	} // if
+	if (0==n) break;
+	used += n;
+    } // while
+    m_buffer.resize(used);
+    m_data = m_buffer.data();
+    m_size = used;
+} // read
+
+/** Maps the file, the size of the map is rounded up to the page size,
+  * the end of the last page (after the end of the file) is filled with zeroes by the kernel.
+  * The descriptor used to get the size is mapped, so that the file mapped is the one whose size is known,
+  * even if the file is renamed over meanwhile.
+  * \param fd descriptor of the file
+  * \param size size of the file
+  * \param name name of the file, for error messages
+  */
+
+void OksSystem::FileContent::map(int fd, size_t size, const std::string &name) {
+    const size_t page_size = ::getpagesize();
+    const size_t map_size = ((size+page_size-1)/page_size)*page_size;
+    void *address = ::mmap(0,map_size,PROT_READ,MAP_SHARED,fd,0);
+    if (MAP_FAILED==address) {
+	std::string message = "on file " + name;
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "mmap", message.c_str() );
+    } // if
+    m_map = address;
+    m_map_size = map_size;
+    m_data = (const char *) address;
+    m_size = size;
+} // map
+
+void OksSystem::FileContent::release() throw() {
+    if (m_map) {
+	::munmap(m_map,m_map_size);
+	m_map = 0;
+	m_map_size = 0;
+    } // if
+    m_data = 0;
+    m_size = 0;
+} // release
@@ -0,0 +1,210 @@
+/*
+ *  FileCopier.cxx
+ *  OksSystem
+ *
+ *  Kernel side copy of files.
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "ers/ers.hpp"
+
+#include "okssystem/FileCopier.hpp"
+#include "okssystem/AtomicWriter.hpp"
+#include "okssystem/File.hpp"
+#include "okssystem/exceptions.hpp"
+
+#include <sys/ioctl.h>                                            // after the package headers, it defines CTIME
+
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)                                // from linux/fs.h, which clashes with the libc headers
+#endif
+
+namespace {
+
+    /** Closes a descriptor when leaving a scope */
+    struct ScopedDescriptor {
+	int fd ;
+	ScopedDescriptor(int f) : fd(f) {}
+	~ScopedDescriptor() { if (fd>=0) ::close(fd); }
+    } ; // ScopedDescriptor
+
+    /** \return \c true if an error of a copy call means the method is not usable for these files */
+    inline bool unsupported(int error) {
+	return error==EXDEV || error==EINVAL || error==ENOSYS || error==EOPNOTSUPP || error==ENOTTY || error==EBADF || error==EPERM;
+    } // unsupported
+
+} // anonymous namespace
+
+const size_t OksSystem::FileCopier::CHUNK_SIZE = 16 * 1024 * 1024;
+const size_t OksSystem::FileCopier::BUFFER_SIZE = 1024 * 1024;
+
+OksSystem::FileCopier::Statistics::Statistics() throw() {
+    bytes = 0;
+    data_bytes = 0;
+    method = CLONE;
+    elapsed_time = 0.0;
+} // Statistics
+
+/** Constructor
+  * \param progress function called after each chunk of data is copied, can be empty
+  * \param method most efficient method to try, less efficient ones are only used if it is not supported
+  */
+
+OksSystem::FileCopier::FileCopier(const progress_t &progress, method_t method) : m_progress(progress) {
+    m_method = method;
+} // FileCopier
+
+const char *OksSystem::FileCopier::method_name(method_t method) throw() {
+    switch (method) {
+	case CLONE: return "clone";
+	case COPY_FILE_RANGE: return "copy_file_range";
+	case SENDFILE: return "sendfile";
+	case BUFFERED: return "buffered";
+    } // switch
+    return "unknown";
+} // method_name
+
+/** Copies a segment of data at the same offset in the destination.
+  * \param source_fd descriptor of the source
+  * \param dest_fd descriptor of the destination
+  * \param offset offset of the segment
+  * \param length length of the segment
+  * \param method most efficient method to try (not \c CLONE)
+  * \param copied number of bytes copied so far, updated 
+  * \param total size of the file, for progress reports
+  * \return the least efficient method used
+  */
+
+OksSystem::FileCopier::method_t OksSystem::FileCopier::copy_range(int source_fd, int dest_fd, off_t offset, size_t length, method_t method, size_t &copied, size_t total) const {
+    const off_t end = offset + length;
+    std::vector<char> buffer;
+    while(offset<end) {
+	const size_t chunk = std::min((size_t) (end-offset),CHUNK_SIZE);
+	ssize_t done = -1;
+	if (method==COPY_FILE_RANGE) {
+	    loff_t in = offset;
+	    loff_t out = offset;
+	    done = ::copy_file_range(source_fd,&in,dest_fd,&out,chunk,0);
+	    if (done<0 && unsupported(errno)) {
+		method = SENDFILE;
+		continue;
+	    } // if
+	    if (done<0) throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "copy_file_range", "while copying file" );
+	} else if (method==SENDFILE) {
+	    if (::lseek(dest_fd,offset,SEEK_SET)<0) {
+		throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "lseek", "while copying file" );
+	    } // if
+	    off_t in = offset;
+	    done = ::sendfile(dest_fd,source_fd,&in,chunk);
+	    if (done<0 && unsupported(errno)) {
+		method = BUFFERED;
+		continue;
+	    } // if
+	    if (done<0) throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "sendfile", "while copying file" );
+	} else {
+	    if (buffer.empty()) buffer.resize(BUFFER_SIZE);
+	    done = ::pread(source_fd,&buffer[0],std::min(chunk,buffer.size()),offset);
+	    if (done<0) {
+		if (errno==EINTR) continue;
+		throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "pread", "while copying file" );
+	    } // if
+	    for(ssize_t written = 0; written<done; ) {
+		const ssize_t w = ::pwrite(dest_fd,&buffer[written],done-written,offset+written);
+		if (w<0) {
+		    if (errno==EINTR) continue;
+		    throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "pwrite", "while copying file" );
+		} // if
+		written += w;
+	    } // for
+	} // if
+	if (0==done) break; // source shrank while being copied
+	offset += done;
+	copied += done;
+	if (m_progress) m_progress(copied,total);
+    } // while
+    return method;
+} // copy_range
+
+/** Copies a regular file. 
+  * The data is copied to a temporary file in the directory of the destination (see OksSystem::AtomicWriter),
+  * which replaces the destination once complete: if the copy fails, an existing destination is left untouched. 
+  * A destination that is a symbolic link is replaced, not written through.
+  * Copying a file onto itself (or onto a hard link to it) is refused.
+  * \param source the file to copy
+  * \param destination the copy
+  * \return statistics about the copy
+  * \exception OksSystem::OpenFileIssue if a file cannot be opened
+  * \exception OksSystem::OksSystemCallIssue if the copy fails
+  * \exception OksSystem::RenameFileIssue if the destination cannot be replaced
+  */
+
+OksSystem::FileCopier::Statistics OksSystem::FileCopier::copy(const File &source, const File &destination) const {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Statistics statistics;
+    ScopedDescriptor in(::open(source.c_full_name(),O_RDONLY | O_CLOEXEC));
+    if (in.fd<0) {
+	throw OksSystem::OpenFileIssue( ERS_HERE, errno, source.c_full_name() );
+    } // if
+    struct stat status;
+    if (0!=::fstat(in.fd,&status)) {
+	std::string message = "on file " + source.full_name();
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "fstat", message.c_str() );
+    } // if
+    if (! S_ISREG(status.st_mode)) {
+	std::string message = "on file " + source.full_name() + " (not a regular file)";
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, EINVAL, "copy", message.c_str() );
+    } // if
+    struct stat dest_status;
+    if (0==::stat(destination.c_full_name(),&dest_status) && dest_status.st_dev==status.st_dev && dest_status.st_ino==status.st_ino) {
+	std::string message = "on file " + source.full_name() + " (source and destination are the same file)";
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, EINVAL, "copy", message.c_str() );
+    } // if
+    statistics.bytes = status.st_size;
+    // the data goes to a temporary file renamed over the destination, which is only replaced by a complete copy
+    AtomicWriter out(destination,status.st_mode & 07777);
+    method_t method = m_method;
+    if (method==CLONE) {
+	if (0==::ioctl(out.fd(),FICLONE,in.fd)) {
+	    statistics.data_bytes = status.st_size;
+	    if (m_progress) m_progress(statistics.bytes,statistics.bytes);
+	} else {
+	    method = COPY_FILE_RANGE;
+	} // if
+    } // if
+    if (method!=CLONE) {
+	const off_t size = status.st_size;
+	size_t copied = 0;
+	off_t position = 0;
+	while(position<size) {
+	    off_t data = ::lseek(in.fd,position,SEEK_DATA);
+	    off_t hole = size;
+	    if (data<0) {
+		if (errno==ENXIO) break; // only a hole is left
+		data = position; // holes not supported, the rest is data
+	    } else {
+		hole = ::lseek(in.fd,data,SEEK_HOLE);
+		if (hole<0 || hole>size) hole = size;
+	    } // if
+	    method = copy_range(in.fd,out.fd(),data,hole-data,method,copied,statistics.bytes);
+	    statistics.data_bytes += hole-data;
+	    position = hole;
+	} // while
+	if (0!=::ftruncate(out.fd(),size)) { // trailing hole
+	    throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "ftruncate", "while copying file" );
+	} // if
+    } // if
+    statistics.method = method;
+    out.commit();
+    statistics.elapsed_time = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return statistics;
+} // copy
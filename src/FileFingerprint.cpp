@@ -0,0 +1,90 @@
+/*
+ *  FileFingerprint.cxx
+ *  OksSystem
+ *
+ *  Cheap change detection for files, based on their metadata.
+ *
+ */
+
+#include <time.h>
+
+#include "okssystem/FileFingerprint.hpp"
+#include "okssystem/FileStatus.hpp"
+
+const unsigned int OksSystem::FileFingerprint::FIELDS = FileStatus::TYPE | FileStatus::INO | FileStatus::SIZE | FileStatus::MTIME | FileStatus::CTIME;
+const int64_t OksSystem::FileFingerprint::RACY_NS = 2000000000; // FAT stores modification times with a two seconds resolution
+
+namespace {
+
+    inline int64_t nanoseconds(const struct timespec &time) {
+	return (int64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+    } // nanoseconds
+
+} // anonymous namespace
+
+OksSystem::FileFingerprint::FileFingerprint() throw() {
+    m_size = 0;
+    m_modification_ns = 0;
+    m_change_ns = 0;
+} // FileFingerprint
+
+/** Builds the fingerprint of a file 
+  * \param status the status of the file, it should contain at least the fields in \c FIELDS
+  */
+
+OksSystem::FileFingerprint::FileFingerprint(const FileStatus &status) throw() : m_id(status.id()) {
+    m_size = status.size();
+    m_modification_ns = nanoseconds(status.modification_time());
+    m_change_ns = nanoseconds(status.change_time());
+} // FileFingerprint
+
+const OksSystem::FileId & OksSystem::FileFingerprint::id() const throw() {
+    return m_id;
+} // id
+
+size_t OksSystem::FileFingerprint::size() const throw() {
+    return m_size;
+} // size
+
+int64_t OksSystem::FileFingerprint::modification_ns() const throw() {
+    return m_modification_ns;
+} // modification_ns
+
+int64_t OksSystem::FileFingerprint::change_ns() const throw() {
+    return m_change_ns;
+} // change_ns
+
+/** \return the current time of the system clock, which the file systems use for the file times */
+
+int64_t OksSystem::FileFingerprint::clock_ns() throw() {
+    struct timespec now;
+    ::clock_gettime(CLOCK_REALTIME,&now);
+    return nanoseconds(now);
+} // clock_ns
+
+/** Checks if the file could have changed without changing the fingerprint.
+  * This is the case when the file times are so recent, compared to the moment the fingerprint was taken,
+  * that a later write could fall in the same tick of the file system clock and leave them (and the size) unchanged.
+  * \param taken_ns time (from \c clock_ns()) just before the status of the file was read
+  * \return \c true if the fingerprint cannot be trusted to detect later changes
+  */
+
+bool OksSystem::FileFingerprint::racy(int64_t taken_ns) const throw() {
+    const int64_t latest = m_modification_ns>m_change_ns ? m_modification_ns : m_change_ns;
+    return latest+RACY_NS>taken_ns;
+} // racy
+
+OksSystem::FileFingerprint::operator bool() const throw() {
+    return (bool) m_id;
+} // operator bool
+
+/** Compares two fingerprints, a null fingerprint is different from everything, including itself */
+
+bool OksSystem::FileFingerprint::operator==(const FileFingerprint &other) const throw() {
+    return (m_id && m_id==other.m_id && m_size==other.m_size 
+	    && m_modification_ns==other.m_modification_ns && m_change_ns==other.m_change_ns);
+} // operator==
+
+bool OksSystem::FileFingerprint::operator!=(const FileFingerprint &other) const throw() {
+    return ! ((*this)==other);
+} // operator!=
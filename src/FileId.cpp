@@ -0,0 +1,61 @@
+/*
+ *  FileId.cxx
+ *  OksSystem
+ *
+ *  Identity of a file on the local system (device and inode numbers).
+ *
+ */
+
+#include "okssystem/FileId.hpp"
+
+OksSystem::FileId::FileId() throw() {
+    m_device = 0;
+    m_inode = 0;
+} // FileId
+
+/** Constructor 
+  * \param device the device containing the file
+  * \param inode the inode number of the file
+  */
+
+OksSystem::FileId::FileId(dev_t device, ino_t inode) throw() {
+    m_device = device;
+    m_inode = inode;
+} // FileId
+
+dev_t OksSystem::FileId::device() const throw() {
+    return m_device;
+} // device
+
+ino_t OksSystem::FileId::inode() const throw() {
+    return m_inode;
+} // inode
+
+/** \return a hash of the identity, inode numbers are mixed so that consecutive inodes spread over buckets */
+
+size_t OksSystem::FileId::hash() const throw() {
+    unsigned long long h = (unsigned long long) m_inode ^ ((unsigned long long) m_device << 32 | (unsigned long long) m_device >> 32);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (size_t) h;
+} // hash
+
+OksSystem::FileId::operator bool() const throw() {
+    return (m_inode!=0);
+} // operator bool
+
+bool OksSystem::FileId::operator==(const FileId &other) const throw() {
+    return (m_inode==other.m_inode && m_device==other.m_device);
+} // operator==
+
+bool OksSystem::FileId::operator!=(const FileId &other) const throw() {
+    return ! ((*this)==other);
+} // operator!=
+
+bool OksSystem::FileId::operator<(const FileId &other) const throw() {
+    if (m_device!=other.m_device) return (m_device<other.m_device);
+    return (m_inode<other.m_inode);
+} // operator<
@@ -0,0 +1,168 @@
+/*
+ *  FileStatus.cxx
+ *  OksSystem
+ *
+ *  Snapshot of the metadata of a file, obtained with a single stat call.
+ *
+ */
+
+#include <string.h>
+
+#include "okssystem/FileStatus.hpp"
+
+/** Builds an empty status, all fields are zero */
+
+OksSystem::FileStatus::FileStatus() throw() {
+    memset(&m_stat,0,sizeof(m_stat));
+    memset(&m_birth_time,0,sizeof(m_birth_time));
+    m_fields = 0;
+} // FileStatus
+
+/** Builds a status out of raw \c stat information
+  * \param status the information filled by \c stat, \c fstat or \c lstat
+  */
+
+OksSystem::FileStatus::FileStatus(const struct stat &status) throw() {
+    m_stat = status;
+    memset(&m_birth_time,0,sizeof(m_birth_time));
+    m_fields = BASIC;
+} // FileStatus
+
+/** Builds a status where only some fields are meaningful 
+  * \param status the raw status information, fields not in \c fields are ignored 
+  * \param fields mask of the fields actually filled (see \c field_t)
+  * \param birth the creation time of the file, only meaningful if \c fields contains \c BTIME
+  */
+
+OksSystem::FileStatus::FileStatus(const struct stat &status, unsigned int fields, const struct timespec &birth) throw() {
+    m_stat = status;
+    m_birth_time = birth;
+    m_fields = fields;
+} // FileStatus
+
+/** \return the mask of the fields actually filled in this status */
+
+unsigned int OksSystem::FileStatus::fields() const throw() {
+    return m_fields;
+} // fields
+
+/** Checks if some fields are filled 
+  * \param fields mask of fields (see \c field_t)
+  * \return \c true if all the fields in the mask are filled
+  */
+
+bool OksSystem::FileStatus::has(unsigned int fields) const throw() {
+    return ((m_fields & fields) == fields);
+} // has
+
+/** \return the raw status information */
+
+const struct stat & OksSystem::FileStatus::stat() const throw() {
+    return m_stat;
+} // stat
+
+/** \return the mode of the file, this contains both the type and the permissions */
+
+mode_t OksSystem::FileStatus::mode() const throw() {
+    return m_stat.st_mode;
+} // mode
+
+/** \return the permissions for the file */
+
+mode_t OksSystem::FileStatus::permissions() const throw() {
+    return (m_stat.st_mode & 07777);
+} // permissions
+
+/** \return the size (in bytes) of the file */
+
+size_t OksSystem::FileStatus::size() const throw() {
+    return m_stat.st_size;
+} // size
+
+/** \return the user-id of the owner of the file */
+
+uid_t OksSystem::FileStatus::owner_id() const throw() {
+    return m_stat.st_uid;
+} // owner_id
+
+/** \return the group-id of the group of the file */
+
+gid_t OksSystem::FileStatus::group() const throw() {
+    return m_stat.st_gid;
+} // group
+
+/** \return the id of the device containing the file */
+
+dev_t OksSystem::FileStatus::device() const throw() {
+    return m_stat.st_dev;
+} // device
+
+/** \return the inode number of the file */
+
+ino_t OksSystem::FileStatus::inode() const throw() {
+    return m_stat.st_ino;
+} // inode
+
+/** \return the identity of the file, hard links to the same file have the same identity */
+
+OksSystem::FileId OksSystem::FileStatus::id() const throw() {
+    return FileId(m_stat.st_dev,m_stat.st_ino);
+} // id
+
+/** \return the number of hard links to the file */
+
+nlink_t OksSystem::FileStatus::links() const throw() {
+    return m_stat.st_nlink;
+} // links
+
+/** \return the number of 512 bytes blocks actually allocated to the file */
+
+blkcnt_t OksSystem::FileStatus::blocks() const throw() {
+    return m_stat.st_blocks;
+} // blocks
+
+/** \return the preferred block size for efficient I/O on the file */
+
+blksize_t OksSystem::FileStatus::block_size() const throw() {
+    return m_stat.st_blksize;
+} // block_size
+
+const struct timespec & OksSystem::FileStatus::modification_time() const throw() {
+    return m_stat.st_mtim;
+} // modification_time
+
+const struct timespec & OksSystem::FileStatus::change_time() const throw() {
+    return m_stat.st_ctim;
+} // change_time
+
+const struct timespec & OksSystem::FileStatus::access_time() const throw() {
+    return m_stat.st_atim;
+} // access_time
+
+const struct timespec & OksSystem::FileStatus::birth_time() const throw() {
+    return m_birth_time;
+} // birth_time
+
+/** \return \c true if the file is a regular file */
+
+bool OksSystem::FileStatus::is_regular() const throw() {
+    return S_ISREG(m_stat.st_mode);
+} // is_regular
+
+/** \return \c true if the file is a directory */
+
+bool OksSystem::FileStatus::is_directory() const throw() {
+    return S_ISDIR(m_stat.st_mode);
+} // is_directory
+
+/** \return \c true if the file is a named pipe (FIFO) */
+
+bool OksSystem::FileStatus::is_fifo() const throw() {
+    return S_ISFIFO(m_stat.st_mode);
+} // is_fifo
+
+/** \return \c true if the file is a symbolic link, this can only be the case for a status obtained without following links */
+
+bool OksSystem::FileStatus::is_symlink() const throw() {
+    return S_ISLNK(m_stat.st_mode);
+} // is_symlink
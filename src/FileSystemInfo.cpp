@@ -0,0 +1,205 @@
+/*
+ *  FileSystemInfo.cxx
+ *  OksSystem
+ *
+ *  Capacity and properties of a mounted file system.
+ *
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include "ers/ers.hpp"
+
+#include "okssystem/FileSystemInfo.hpp"
+#include "okssystem/File.hpp"
+#include "okssystem/exceptions.hpp"
+
+namespace {
+
+    /** Cache of file system information, indexed by device */
+    std::mutex s_cache_mutex;
+    std::map<dev_t, OksSystem::FileSystemInfo> s_cache;
+
+    /** Names of common file system types, indexed by magic number (see \c statfs(2)) */
+    struct TypeName {
+	unsigned long magic ;
+	const char *name ;
+    } ; 
+
+    const TypeName TYPE_NAMES[] = {
+	{ 0xEF53,     "ext2/ext3/ext4" },
+	{ 0x58465342, "xfs" },
+	{ 0x9123683E, "btrfs" },
+	{ 0x01021994, "tmpfs" },
+	{ 0x6969,     "nfs" },
+	{ 0xFF534D42, "cifs" },
+	{ 0x65735546, "fuse" },
+	{ 0x794C7630, "overlayfs" },
+	{ 0x2FC12FC1, "zfs" },
+	{ 0x00C36400, "ceph" },
+	{ 0x0BD00BD0, "lustre" },
+	{ 0x47504653, "gpfs" },
+	{ 0x9FA0,     "proc" },
+	{ 0x62656572, "sysfs" },
+	{ 0x858458F6, "ramfs" },
+	{ 0x4d44,     "vfat" },
+	{ 0x5346544e, "ntfs" },
+	{ 0x3153464a, "jfs" },
+	{ 0x52654973, "reiserfs" },
+	{ 0x73717368, "squashfs" },
+	{ 0x9660,     "iso9660" },
+	{ 0, 0 }
+    } ; 
+
+} // anonymous namespace
+
+const double OksSystem::FileSystemInfo::CACHE_TIME = 2.0;
+
+/** Information about the file system containing a file, from the cache if possible.
+  * The cache is indexed by device, so all the files of a file system share the same entry. 
+  * \param file the file, it must exist
+  * \param max_age maximum age of cached information (in seconds), 0 forces a new query
+  * \return the information about the file system
+  * \exception OksSystem::OksSystemCallIssue if the file or the file system cannot be queried
+  */
+
+OksSystem::FileSystemInfo OksSystem::FileSystemInfo::get(const File &file, double max_age) {
+    const dev_t device = file.status().device();
+    if (max_age>0.0) {
+	std::lock_guard<std::mutex> lock(s_cache_mutex);
+	std::map<dev_t, FileSystemInfo>::const_iterator pos = s_cache.find(device);
+	if (pos!=s_cache.end() && pos->second.age()<=max_age) return pos->second;
+    } // if
+    const FileSystemInfo info(file);
+    std::lock_guard<std::mutex> lock(s_cache_mutex);
+    s_cache[info.device()] = info;
+    return info;
+} // get
+
+/** Discards all cached information, the next calls to \c get() query the file systems again */
+
+void OksSystem::FileSystemInfo::invalidate() {
+    std::lock_guard<std::mutex> lock(s_cache_mutex);
+    s_cache.clear();
+} // invalidate
+
+/** \return the number of seconds elapsed since \c time, taken from the monotonic clock */
+
+double OksSystem::FileSystemInfo::age(const struct timespec &time) throw() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return (now.tv_sec-time.tv_sec) + (now.tv_nsec-time.tv_nsec) * 1e-9;
+} // age
+
+OksSystem::FileSystemInfo::FileSystemInfo() throw() {
+    memset(&m_stat,0,sizeof(m_stat));
+    memset(&m_time,0,sizeof(m_time));
+    m_type = 0;
+    m_device = 0;
+} // FileSystemInfo
+
+/** Queries the file system containing a file, bypassing the cache.
+  * \param file the file, it must exist
+  * \exception OksSystem::OksSystemCallIssue if \c statvfs or \c statfs fails
+  */
+
+OksSystem::FileSystemInfo::FileSystemInfo(const File &file) {
+    m_device = file.status().device();
+    if (0!=::statvfs(file.c_full_name(),&m_stat)) {
+	std::string message = "on file/directory " + file.full_name();
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "statvfs", message.c_str() );
+    } // if
+    struct statfs fs_status;
+    if (0!=::statfs(file.c_full_name(),&fs_status)) {
+	std::string message = "on file/directory " + file.full_name();
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "statfs", message.c_str() );
+    } // if
+    m_type = (unsigned long) fs_status.f_type;
+    clock_gettime(CLOCK_MONOTONIC,&m_time);
+} // FileSystemInfo
+
+dev_t OksSystem::FileSystemInfo::device() const throw() {
+    return m_device;
+} // device
+
+/** \return the number of seconds since the information was obtained */
+
+double OksSystem::FileSystemInfo::age() const throw() {
+    return age(m_time);
+} // age
+
+/** \return the preferred block size for I/O, buffers should be a multiple of it */
+
+size_t OksSystem::FileSystemInfo::block_size() const throw() {
+    return m_stat.f_bsize;
+} // block_size
+
+size_t OksSystem::FileSystemInfo::fragment_size() const throw() {
+    return m_stat.f_frsize;
+} // fragment_size
+
+size_t OksSystem::FileSystemInfo::total_bytes() const throw() {
+    return (size_t) m_stat.f_blocks * m_stat.f_frsize;
+} // total_bytes
+
+size_t OksSystem::FileSystemInfo::free_bytes() const throw() {
+    return (size_t) m_stat.f_bfree * m_stat.f_frsize;
+} // free_bytes
+
+size_t OksSystem::FileSystemInfo::available_bytes() const throw() {
+    return (size_t) m_stat.f_bavail * m_stat.f_frsize;
+} // available_bytes
+
+size_t OksSystem::FileSystemInfo::total_inodes() const throw() {
+    return m_stat.f_files;
+} // total_inodes
+
+size_t OksSystem::FileSystemInfo::free_inodes() const throw() {
+    return m_stat.f_ffree;
+} // free_inodes
+
+size_t OksSystem::FileSystemInfo::available_inodes() const throw() {
+    return m_stat.f_favail;
+} // available_inodes
+
+size_t OksSystem::FileSystemInfo::max_name_length() const throw() {
+    return m_stat.f_namemax;
+} // max_name_length
+
+unsigned long OksSystem::FileSystemInfo::type() const throw() {
+    return m_type;
+} // type
+
+/** \return the name of the file system type, or the magic number in hexadecimal if the type is not known */
+
+std::string OksSystem::FileSystemInfo::type_name() const {
+    for(const TypeName *t = TYPE_NAMES; t->name; t++) {
+	if (t->magic==m_type) return t->name;
+    } // for
+    std::ostringstream stream;
+    stream << "0x" << std::hex << m_type;
+    return stream.str();
+} // type_name
+
+unsigned long OksSystem::FileSystemInfo::flags() const throw() {
+    return m_stat.f_flag;
+} // flags
+
+bool OksSystem::FileSystemInfo::is_read_only() const throw() {
+    return (m_stat.f_flag & ST_RDONLY)!=0;
+} // is_read_only
+
+/** \param bytes the number of bytes needed
+  * \return \c true if at least \c bytes are available for unprivileged users 
+  */
+
+bool OksSystem::FileSystemInfo::has_space(size_t bytes) const throw() {
+    return available_bytes()>=bytes;
+} // has_space
@@ -0,0 +1,256 @@
+/*
+ *  FileWatcher.cxx
+ *  OksSystem
+ *
+ *  Notification of changes to files and directories (inotify).
+ *
+ */
+
+#include <chrono>
+#include <exception>
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+#include "ers/ers.hpp"
+#include "ers/Assertion.hpp"
+
+#include "okssystem/FileWatcher.hpp"
+#include "okssystem/exceptions.hpp"
+
+const size_t OksSystem::FileWatcher::BUFFER_SIZE = 64*1024;
+
+namespace {
+
+    /** Watcher whose callback thread is the current thread, if any */
+    thread_local const OksSystem::FileWatcher *callback_watcher = 0;
+
+} // anonymous namespace
+
+/** Builds a watcher, with no file watched
+  * \exception OksSystem::OksSystemCallIssue if the inotify descriptor cannot be created
+  */
+
+OksSystem::FileWatcher::FileWatcher() : m_running(false), m_stopping(false) {
+    m_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd<0) {
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "inotify_init1", "while creating a file watcher" );
+    } // if
+    m_stop_fd = ::eventfd(0,EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_stop_fd<0) {
+	const int error = errno;
+	::close(m_fd);
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, error, "eventfd", "while creating a file watcher" );
+    } // if
+} // FileWatcher
+
+/** Destructor, stops the callback thread and closes the descriptors (which removes the watches) */
+
+OksSystem::FileWatcher::~FileWatcher() {
+    stop();
+    ::close(m_stop_fd);
+    ::close(m_fd);
+} // ~FileWatcher
+
+/** Starts watching a file or a directory.
+  * Watching a directory reports the events of its entries, not of its subdirectories.
+  * Watching a file again replaces the events watched.
+  * \param file the file or directory
+  * \param events mask of the events to report
+  * \exception OksSystem::OksSystemCallIssue if the file cannot be watched (for instance if it does not exist)
+  */
+
+void OksSystem::FileWatcher::watch(const File &file, unsigned int events) {
+    const std::string &path = file.full_name();
+    const int wd = ::inotify_add_watch(m_fd,path.c_str(),events);
+    if (wd<0) {
+	std::string message = "on file " + path;
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "inotify_add_watch", message.c_str() );
+    } // if
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_paths[wd] = path;
+    m_watches[path] = wd;
+} // watch
+
+/** Stops watching a file or a directory, nothing is done if it is not watched */
+
+void OksSystem::FileWatcher::unwatch(const File &file) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unordered_map<std::string, int>::iterator pos = m_watches.find(file.full_name());
+    if (pos==m_watches.end()) return;
+    ::inotify_rm_watch(m_fd,pos->second);
+    m_paths.erase(pos->second);
+    m_watches.erase(pos);
+} // unwatch
+
+bool OksSystem::FileWatcher::is_watched(const File &file) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_watches.find(file.full_name())!=m_watches.end();
+} // is_watched
+
+/** \return the inotify descriptor, it becomes readable when events are pending */
+
+int OksSystem::FileWatcher::fd() const throw() {
+    return m_fd;
+} // fd
+
+/** Decodes raw events, the events of a file already in the batch are merged into its entry.
+  * A watch removed by the kernel (the file was deleted) is forgotten.
+  */
+
+void OksSystem::FileWatcher::decode(const char *buffer, size_t size, event_list_t &events, std::unordered_map<std::string, size_t> &index) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t offset = 0;
+    while(offset+sizeof(struct inotify_event)<=size) {
+	const struct inotify_event *raw = (const struct inotify_event *) (buffer+offset);
+	offset += sizeof(struct inotify_event) + raw->len;
+	std::string path;
+	if (raw->mask & IN_Q_OVERFLOW) {
+	    path = "/";
+	} else {
+	    std::map<int, std::string>::iterator pos = m_paths.find(raw->wd);
+	    if (pos==m_paths.end()) continue;
+	    path = pos->second;
+	    if (raw->mask & IN_IGNORED) {
+		m_watches.erase(path);
+		m_paths.erase(pos);
+	    } // if
+	    if (raw->len>0 && raw->name[0]!=0) {
+		path += "/";
+		path += raw->name;
+	    } // if
+	} // if
+	const unsigned int mask = raw->mask & (DEFAULT | QUEUE_OVERFLOW);
+	if (0==mask) continue;
+	const bool directory = (raw->mask & IN_ISDIR)!=0;
+	std::unordered_map<std::string, size_t>::iterator pos = index.find(path);
+	if (pos==index.end()) {
+	    index[path] = events.size();
+	    events.push_back(Event(File(path,File::LEXICAL),mask,directory));
+	} else {
+	    events[pos->second].events |= mask;
+	} // if
+    } // while
+} // decode
+
+/** Reads the pending events.
+  * All the events available are read, the events of the same file are coalesced.
+  * \param events list where the events are added
+  * \param timeout time to wait for the first event, in milliseconds, -1 to wait forever
+  * \return the number of events added
+  * \exception OksSystem::OksSystemCallIssue if the events cannot be read
+  */
+
+size_t OksSystem::FileWatcher::read(event_list_t &events, int timeout) {
+    const size_t first = events.size();
+    struct pollfd poll_fd = { m_fd, POLLIN, 0 };
+    int status = ::poll(&poll_fd,1,timeout);
+    if (status<0 && EINTR!=errno) {
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "poll", "while waiting for file events" );
+    } // if
+    if (status<=0) return 0;
+    std::unordered_map<std::string, size_t> index;
+    std::vector<char> buffer(BUFFER_SIZE);
+    while(true) {
+	const ssize_t n = ::read(m_fd,buffer.data(),buffer.size());
+	if (n<0) {
+	    if (EINTR==errno) continue;
+	    if (EAGAIN==errno) break;
+	    throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "read", "while reading file events" );
+	} // if
+	decode(buffer.data(),n,events,index);
+    } // while
+    return events.size()-first;
+} // read
+
+/** Waits until one of the given events happens to a file.
+  * The file, or its directory, must be watched. The other events read meanwhile are dropped,
+  * so this should not be used while the callback thread is running.
+  * \param file the file
+  * \param events mask of the events to wait for
+  * \param timeout maximum time to wait, in milliseconds, -1 to wait forever
+  * \return \c true if the event happened, \c false on timeout
+  */
+
+bool OksSystem::FileWatcher::wait_for(const File &file, unsigned int events, int timeout) {
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    while(true) {
+	int remaining = -1;
+	if (timeout>=0) {
+	    remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline-std::chrono::steady_clock::now()).count();
+	    if (remaining<0) return false;
+	} // if
+	event_list_t list;
+	read(list,remaining);
+	for(size_t i=0;i<list.size();i++) {
+	    if (list[i].file.equals(file) && list[i].has(events)) return true;
+	} // for
+    } // while
+} // wait_for
+
+/** Starts a thread calling a function for each event.
+  * Exceptions thrown by the function are reported as warnings.
+  * \param callback the function
+  */
+
+void OksSystem::FileWatcher::start(const callback_t &callback) {
+    ERS_PRECONDITION(! m_running);
+    m_running = true;
+    m_stopping = false;
+    m_thread = std::thread(&FileWatcher::run,this,callback);
+} // start
+
+/** Stops the callback thread, the events not delivered yet stay pending.
+  * When called by the callback itself, the thread ends when the callback returns,
+  * without delivering the other events, it is joined by the next call to \c stop() or by the destructor
+  * (so the watcher must not be destroyed by its own callback).
+  */
+
+void OksSystem::FileWatcher::stop() {
+    if (! m_running) return;
+    if (! m_stopping.exchange(true)) {
+	const uint64_t one = 1;
+	while(::write(m_stop_fd,&one,sizeof(one))<0 && EINTR==errno) {}
+    } // if
+    if (callback_watcher==this) return; // called by the callback, the thread cannot join itself
+    m_thread.join();
+    uint64_t count;
+    while(::read(m_stop_fd,&count,sizeof(count))<0 && EINTR==errno) {}
+    m_running = false;
+} // stop
+
+void OksSystem::FileWatcher::run(callback_t callback) {
+    callback_watcher = this;
+    struct pollfd poll_fds[2] = { { m_fd, POLLIN, 0 }, { m_stop_fd, POLLIN, 0 } };
+    while(true) {
+	const int status = ::poll(poll_fds,2,-1);
+	if (status<0) {
+	    if (EINTR==errno) continue;
+	    ers::warning(OksSystem::OksSystemCallIssue( ERS_HERE, errno, "poll", "in the file watcher thread" ));
+	    return;
+	} // if
+	if (poll_fds[1].revents & POLLIN) return;
+	event_list_t events;
+	try {
+	    read(events,0);
+	} catch (ers::Issue &ex) {
+	    ers::warning(ex);
+	    return;
+	} // catch
+	for(size_t i=0;i<events.size() && ! m_stopping;i++) {
+	    try {
+		callback(events[i]);
+	    } catch (ers::Issue &ex) {
+		ers::warning(ex);
+	    } catch (std::exception &ex) {
+		ers::warning(OksSystem::Exception(ERS_HERE, std::string("File watcher callback failed: ") + ex.what()));
+	    } catch (...) {
+		ers::warning(OksSystem::Exception(ERS_HERE, std::string("File watcher callback failed with an unknown exception")));
+	    } // catch
+	} // for
+	if (m_stopping) return;
+    } // while
+} // run
@@ -0,0 +1,125 @@
+/*
+ *  FingerprintCache.cxx
+ *  OksSystem
+ *
+ *  Process wide cache of file fingerprints and of content derived from files.
+ *
+ */
+
+#include <errno.h>
+
+#include "okssystem/FingerprintCache.hpp"
+
+/** \return the cache, it is never destroyed so that it can be used by static objects */
+
+OksSystem::FingerprintCache & OksSystem::FingerprintCache::instance() {
+    static FingerprintCache *s_instance = new FingerprintCache();
+    return *s_instance;
+} // instance
+
+OksSystem::FingerprintCache::FingerprintCache() {
+} // FingerprintCache
+
+/** Finds content derived from a file 
+  * \param file the file
+  * \param key the name and type of the content
+  * \param current the current fingerprint of the file
+  * \return the content if the file did not change since it was stored, null otherwise or if the recorded fingerprint is racy
+  */
+
+std::shared_ptr<const void> OksSystem::FingerprintCache::lookup(const File &file, const key_t &key, const FileFingerprint &current) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unordered_map<File, Record>::iterator pos = m_records.find(file);
+    if (pos==m_records.end()) return std::shared_ptr<const void>();
+    Record &record = pos->second;
+    if (record.m_fingerprint!=current) {
+	record.m_content.clear(); // everything derived from the old file is stale
+	return std::shared_ptr<const void>();
+    } // if
+    if (record.m_racy) return std::shared_ptr<const void>(); // the file may have changed without changing the fingerprint
+    std::map<key_t, std::shared_ptr<const void> >::const_iterator content = record.m_content.find(key);
+    if (content==record.m_content.end()) return std::shared_ptr<const void>();
+    return content->second;
+} // lookup
+
+/** Records content derived from a file 
+  * \param file the file
+  * \param key the name and type of the content
+  * \param current the fingerprint of the file before the content was computed
+  * \param taken_ns the time just before the fingerprint was taken
+  * \param content the content
+  */
+
+void OksSystem::FingerprintCache::store(const File &file, const key_t &key, const FileFingerprint &current, int64_t taken_ns, const std::shared_ptr<const void> &content) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    record(file,current,taken_ns);
+    m_records[file].m_content[key] = content;
+} // store
+
+/** Records the fingerprint of a file, the mutex must be held.
+  * Content derived from a previous version of the file, or recorded with a racy fingerprint
+  * (which may belong to a previous version as well), is discarded.
+  * \param file the file
+  * \param current the current fingerprint of the file
+  * \param taken_ns the time just before the fingerprint was taken
+  * \return \c true if the previous fingerprint differs or could not prove that the file is unchanged
+  */
+
+bool OksSystem::FingerprintCache::record(const File &file, const FileFingerprint &current, int64_t taken_ns) {
+    Record &record = m_records[file];
+    if (record.m_fingerprint==current && ! record.m_racy) return false;
+    record.m_content.clear();
+    record.m_fingerprint = current;
+    record.m_racy = current.racy(taken_ns);
+    return true;
+} // record
+
+/** Takes the current fingerprint of a file and records it.
+  * Content derived from a previous version of the file is discarded. 
+  * \param file the file
+  * \return the fingerprint
+  * \exception OksSystem::OksSystemCallIssue if the file cannot be queried
+  */
+
+OksSystem::FileFingerprint OksSystem::FingerprintCache::fingerprint(const File &file) {
+    const int64_t taken = FileFingerprint::clock_ns();
+    const FileFingerprint current(file.query(FileFingerprint::FIELDS));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    record(file,current,taken);
+    return current;
+} // fingerprint
+
+/** Checks if a file changed since its fingerprint was last recorded.
+  * The new fingerprint is recorded, so the next call only reports later changes. 
+  * A file that is not in the cache, or that does not exist, is reported as changed.
+  * So is a file whose recorded fingerprint was racy, as it may have been rewritten without changing it.
+  * \param file the file
+  * \return \c true if the file changed, or might have
+  */
+
+bool OksSystem::FingerprintCache::changed(const File &file) {
+    const int64_t taken = FileFingerprint::clock_ns();
+    FileStatus status;
+    if (0!=File::query(file.c_full_name(),FileFingerprint::FIELDS,File::SYNC_AS_STAT,status)) {
+	forget(file);
+	return true;
+    } // if
+    const FileFingerprint current(status);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return record(file,current,taken);
+} // changed
+
+void OksSystem::FingerprintCache::forget(const File &file) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_records.erase(file);
+} // forget
+
+void OksSystem::FingerprintCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_records.clear();
+} // clear
+
+size_t OksSystem::FingerprintCache::size() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_records.size();
+} // size
@@ -0,0 +1,140 @@
+/*
+ *  InternedPath.cxx
+ *  OksSystem
+ *
+ *  Compact shared handle on a path stored in a process wide table.
+ *
+ */
+
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+#include "okssystem/InternedPath.hpp"
+
+namespace {
+
+    /** Process wide table of paths.
+      * The table is split in shards, each protected by its own mutex, so that threads
+      * building files in parallel do not all contend on the same lock.
+      * The reference count of an entry only goes from 1 to 0 (and the entry is removed)
+      * while holding the lock of its shard, lookups also increment it under the lock,
+      * so a lookup can never return an entry being freed.
+      */
+
+    class PathTable {
+    public:
+	static const size_t SHARD_COUNT = 64 ;
+	typedef OksSystem::InternedPath::Entry Entry ;
+
+	struct Shard {
+	    std::mutex m_mutex ;
+	    std::unordered_map<std::string_view, Entry*> m_entries ;
+	} ;
+
+	Shard m_shards[SHARD_COUNT] ;
+
+	/** \return the table, it is never destroyed so that static File objects can outlive it */
+	static PathTable & instance() {
+	    static PathTable *s_instance = new PathTable();
+	    return *s_instance;
+	} // instance
+
+	Shard & shard(size_t hash) {
+	    return m_shards[hash % SHARD_COUNT];
+	} // shard
+
+	Entry *intern(const std::string &path) {
+	    const size_t hash = std::hash<std::string_view>()(path);
+	    Shard &s = shard(hash);
+	    std::lock_guard<std::mutex> lock(s.m_mutex);
+	    std::unordered_map<std::string_view, Entry*>::iterator pos = s.m_entries.find(path);
+	    if (pos!=s.m_entries.end()) {
+		pos->second->m_references++;
+		return pos->second;
+	    } // if
+	    Entry *entry = new Entry(path,hash);
+	    s.m_entries.insert(std::make_pair(std::string_view(entry->m_path),entry));
+	    return entry;
+	} // intern
+
+	void release(Entry *entry) {
+	    size_t references = entry->m_references.load();
+	    while(references>1) {
+		if (entry->m_references.compare_exchange_weak(references,references-1)) return;
+	    } // while
+	    Shard &s = shard(entry->m_hash);
+	    std::lock_guard<std::mutex> lock(s.m_mutex);
+	    if (--(entry->m_references)==0) {
+		s.m_entries.erase(std::string_view(entry->m_path));
+		delete entry;
+	    } // if
+	} // release
+
+	size_t size() {
+	    size_t count = 0;
+	    for(size_t i=0;i<SHARD_COUNT;i++) {
+		std::lock_guard<std::mutex> lock(m_shards[i].m_mutex);
+		count += m_shards[i].m_entries.size();
+	    } // for
+	    return count;
+	} // size
+    } ; // PathTable
+
+} // anonymous namespace
+
+const std::string OksSystem::InternedPath::EMPTY;
+
+/** \return the number of distinct paths currently stored in the table */
+
+size_t OksSystem::InternedPath::table_size() {
+    return PathTable::instance().size();
+} // table_size
+
+/** Builds a handle on the empty path */
+
+OksSystem::InternedPath::InternedPath() throw() {
+    m_entry = 0;
+} // InternedPath
+
+/** Builds a handle on a path, the path is added to the table if needed
+  * \param path the path
+  */
+
+OksSystem::InternedPath::InternedPath(const std::string &path) {
+    m_entry = path.empty() ? 0 : PathTable::instance().intern(path);
+} // InternedPath
+
+/** Copy constructor, this only increments the reference count of the entry */
+
+OksSystem::InternedPath::InternedPath(const InternedPath &other) throw() {
+    m_entry = other.m_entry;
+    if (m_entry) m_entry->m_references++;
+} // InternedPath
+
+OksSystem::InternedPath::~InternedPath() {
+    release();
+} // ~InternedPath
+
+OksSystem::InternedPath & OksSystem::InternedPath::operator=(const InternedPath &other) throw() {
+    if (m_entry!=other.m_entry) {
+	if (other.m_entry) other.m_entry->m_references++;
+	release();
+	m_entry = other.m_entry;
+    } // if
+    return *this;
+} // operator=
+
+void OksSystem::InternedPath::release() throw() {
+    if (m_entry) {
+	PathTable::instance().release(m_entry);
+	m_entry = 0;
+    } // if
+} // release
+
+/** \return the hash of the path, computed once when the path was added to the table */
+
+size_t OksSystem::InternedPath::hash() const throw() {
+    return m_entry ? m_entry->m_hash : std::hash<std::string_view>()(EMPTY);
+} // hash
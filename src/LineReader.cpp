@@ -0,0 +1,203 @@
+/*
+ *  LineReader.cxx
+ *  OksSystem
+ *
+ *  Fast line by line reading of text files.
+ *
+ */
+
+#include <atomic>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "okssystem/LineReader.hpp"
+#include "okssystem/WorkerPool.hpp"
+#include "okssystem/exceptions.hpp"
+
+const size_t OksSystem::LineReader::BLOCK_SIZE = 1024*1024;
+const size_t OksSystem::LineReader::MIN_CHUNK_SIZE = 4*1024*1024;
+
+namespace {
+
+    /** Calls a function for each line of a block of text
+      * \return the number of lines
+      */
+
+    size_t scan_lines(const char *position, const char *end, const OksSystem::LineReader::line_callback_t &callback, size_t chunk) {
+	size_t count = 0;
+	while(position<end) {
+	    const char *line_end = (const char *) memchr(position,'\n',end-position);
+	    if (0==line_end) line_end = end;
+	    callback(std::string_view(position,line_end-position),chunk);
+	    count++;
+	    position = line_end+1;
+	} // while
+	return count;
+    } // scan_lines
+
+} // anonymous namespace
+
+/** Opens a file for reading its lines.
+  * \param file the file
+  * \param mode how the file is read, in \c AUTO mode regular files are held in memory, other files are read in blocks
+  * \param block_size size of the blocks read, in block mode, it grows if a line is longer
+  * \exception OksSystem::OpenFileIssue if the file cannot be opened
+  * \exception OksSystem::ReadIssue if the file cannot be read
+  */
+
+OksSystem::LineReader::LineReader(const File &file, mode_t mode, size_t block_size) {
+    m_position = 0;
+    m_end = 0;
+    m_line_number = 0;
+    m_eof = false;
+    if (AUTO==mode) {
+	struct stat status;
+	mode = (0==::stat(file.c_full_name(),&status) && S_ISREG(status.st_mode)) ? MEMORY : BLOCK;
+    } // if
+    if (MEMORY==mode) {
+	m_content.reset(new FileContent(file));
+	m_position = m_content->begin();
+	m_end = m_content->end();
+	m_eof = true;
+    } else {
+	const int fd = ::open(file.c_full_name(),O_RDONLY | O_CLOEXEC);
+	if (fd<0) {
+	    throw OksSystem::OpenFileIssue( ERS_HERE, errno, file.c_full_name() );
+	} // if
+	m_descriptor.reset(new Descriptor(fd,file.full_name()));
+	::posix_fadvise(fd,0,0,POSIX_FADV_SEQUENTIAL);
+	m_buffer.resize((block_size>0) ? block_size : BLOCK_SIZE);
+	m_position = m_buffer.data();
+	m_end = m_buffer.data();
+    } // if
+} // LineReader
+
+OksSystem::LineReader::~LineReader() {
+} // ~LineReader
+
+/** Reads the next block, the beginning of the current line is moved to the start of the buffer,
+  * the buffer is enlarged if it is entirely used by this line.
+  * \return \c true if data was read
+  * \exception OksSystem::ReadIssue if the file cannot be read
+  */
+
+bool OksSystem::LineReader::fill() {
+    if (m_eof) return false;
+    const size_t offset = m_position-m_buffer.data();
+    const size_t remainder = m_end-m_position;
+    if (remainder==m_buffer.size()) {
+	m_buffer.resize(2*m_buffer.size());
+    } // if
+    memmove(m_buffer.data(),m_buffer.data()+offset,remainder);
+    m_position = m_buffer.data();
+    m_end = m_buffer.data()+remainder;
+    while(true) {
+	const ssize_t n = ::read(m_descriptor->fd(),m_buffer.data()+remainder,m_buffer.size()-remainder);
+	if (n<0) {
+	    if (EINTR==errno) continue;
+	    throw OksSystem::ReadIssue( ERS_HERE, errno, m_descriptor->name().c_str() );
+	} // if
+	if (0==n) {
+	    m_eof = true;
+	    return false;
+	} // if
+	m_end += n;
+	return true;
+    } // while
+} // fill
+
+/** Gets the next line.
+  * When the whole file is in memory, the line stays valid as long as the reader,
+  * when the file is read in blocks, it is only valid until the next call.
+  * \param line the line, without the line end
+  * \return \c false at the end of the file
+  * \exception OksSystem::ReadIssue if the file cannot be read
+  */
+
+bool OksSystem::LineReader::next(std::string_view &line) {
+    size_t scanned = 0;
+    while(true) {
+	const char *line_end = (const char *) memchr(m_position+scanned,'\n',(m_end-m_position)-scanned);
+	if (line_end) {
+	    line = std::string_view(m_position,line_end-m_position);
+	    m_position = line_end+1;
+	    m_line_number++;
+	    return true;
+	} // if
+	scanned = m_end-m_position;
+	if (! fill()) break;
+    } // while
+    if (m_position<m_end) {
+	line = std::string_view(m_position,m_end-m_position);
+	m_position = m_end;
+	m_line_number++;
+	return true;
+    } // if
+    return false;
+} // next
+
+size_t OksSystem::LineReader::line_number() const throw() {
+    return m_line_number;
+} // line_number
+
+bool OksSystem::LineReader::is_in_memory() const throw() {
+    return m_content!=0;
+} // is_in_memory
+
+/** Computes the number of chunks of a parallel iteration:
+  * a few chunks per worker, so that the load is balanced, but no chunk smaller than \c MIN_CHUNK_SIZE.
+  * \param size size of the file
+  * \param workers number of workers, 0 means \c WorkerPool::default_size()
+  * \return the number of chunks
+  */
+
+size_t OksSystem::LineReader::chunk_count(size_t size, unsigned int workers) throw() {
+    if (0==workers) workers = WorkerPool::default_size();
+    size_t count = size/MIN_CHUNK_SIZE;
+    if (count>4*(size_t) workers) count = 4*(size_t) workers;
+    return (count>0) ? count : 1;
+} // chunk_count
+
+/** Calls a function for each line of a file, the file being processed in parallel.
+  * The file is held in memory (mapped if large) and split in chunks starting at line boundaries,
+  * the lines of a chunk are given in order by a single worker, but the chunks are processed concurrently,
+  * so the function must be thread safe. The index of the chunk allows per chunk results to be combined in order.
+  * \param file the file
+  * \param callback the function called for each line
+  * \param workers number of threads, 0 means \c WorkerPool::default_size()
+  * \return the number of lines
+  * \exception OksSystem::OpenFileIssue if the file cannot be opened
+  * \exception any exception thrown by the function
+  */
+
+size_t OksSystem::LineReader::for_each(const File &file, const line_callback_t &callback, unsigned int workers) {
+    const FileContent content(file);
+    const size_t size = content.size();
+    const size_t chunks = chunk_count(size,workers);
+    std::vector<const char *> starts(chunks+1,content.end());
+    starts[0] = content.begin();
+    for(size_t i=1;i<chunks;i++) {
+	const char *nominal = content.begin() + (size/chunks)*i;
+	if (nominal<starts[i-1]) nominal = starts[i-1];
+	const char *line_end = (const char *) memchr(nominal-1,'\n',content.end()-(nominal-1));
+	starts[i] = line_end ? line_end+1 : content.end();
+    } // for
+    if (1==chunks) {
+	return scan_lines(starts[0],starts[1],callback,0);
+    } // if
+    std::atomic<size_t> count(0);
+    WorkerPool pool(workers);
+    for(size_t i=0;i<chunks;i++) {
+	const char *begin = starts[i];
+	const char *end = starts[i+1];
+	pool.submit([begin,end,i,&callback,&count]() {
+	    count += scan_lines(begin,end,callback,i);
+	});
+    } // for
+    pool.wait();
+    return count;
+} // for_each
@@ -0,0 +1,212 @@
+/*
+ *  TemporaryFile.cxx
+ *  OksSystem
+ *
+ *  Temporary files created and opened in one system call.
+ *
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "ers/ers.hpp"
+
+#include "okssystem/TemporaryFile.hpp"
+#include "okssystem/File.hpp"
+#include "okssystem/exceptions.hpp"
+
+const size_t OksSystem::TemporaryFilePool::DEFAULT_CAPACITY = 64;
+
+/** Gives a name to an anonymous (\c O_TMPFILE) file.
+  * Linking the descriptor itself (\c AT_EMPTY_PATH) needs privileges,
+  * otherwise the file is linked through \c /proc/self/fd.
+  * \param fd descriptor of the file
+  * \param name the name to give, it must not exist
+  * \return 0 on success, or the error code
+  */
+
+int OksSystem::TemporaryFile::link_descriptor(int fd, const std::string &name) throw() {
+    if (0==::linkat(fd,"",AT_FDCWD,name.c_str(),AT_EMPTY_PATH)) return 0;
+    if (EEXIST==errno) return EEXIST;
+    char path[64];
+    snprintf(path,sizeof(path),"/proc/self/fd/%d",fd);
+    if (0==::linkat(AT_FDCWD,path,AT_FDCWD,name.c_str(),AT_SYMLINK_FOLLOW)) return 0;
+    return errno;
+} // link_descriptor
+
+/** Creates and opens a temporary file for reading and writing.
+  * \param directory the directory of the file
+  * \param prefix prefix of the name of a named file
+  * \param named should the file have a name, else an anonymous file is created if the file system supports it
+  * \param permissions permissions of the file
+  * \exception OksSystem::OpenFileIssue if the file cannot be created
+  */
+
+OksSystem::TemporaryFile::TemporaryFile(const File &directory, const std::string &prefix, bool named, mode_t permissions) {
+    m_directory = directory.full_name();
+    m_keep = false;
+    int fd = -1;
+    if (! named) {
+	fd = ::open(m_directory.c_str(),O_TMPFILE | O_RDWR | O_CLOEXEC,permissions);
+	named = (fd<0 && (EOPNOTSUPP==errno || EISDIR==errno || EINVAL==errno));
+    } // if
+    if (named) {
+	std::string name = m_directory + "/" + prefix + "XXXXXX";
+	fd = ::mkostemp(&name[0],O_CLOEXEC);
+	if (fd>=0) {
+	    m_name = name;
+	    if (0600!=permissions) ::fchmod(fd,permissions);
+	} // if
+    } // if
+    if (fd<0) {
+	throw OksSystem::OpenFileIssue( ERS_HERE, errno, m_directory.c_str() );
+    } // if
+    m_descriptor.reset(new Descriptor(fd,m_name.empty() ? m_directory : m_name));
+} // TemporaryFile
+
+/** Move constructor, the other object is left without file */
+
+OksSystem::TemporaryFile::TemporaryFile(TemporaryFile &&other) throw() : m_descriptor(std::move(other.m_descriptor)), m_directory(std::move(other.m_directory)), m_name(std::move(other.m_name)) {
+    m_keep = other.m_keep;
+    other.m_name.clear();
+} // TemporaryFile
+
+/** Destructor, closes the file and removes it if it is named and was not kept */
+
+OksSystem::TemporaryFile::~TemporaryFile() {
+    if (! m_name.empty() && ! m_keep) {
+	::unlink(m_name.c_str());
+    } // if
+} // ~TemporaryFile
+
+/** The file, an anonymous file is designated through \c /proc/self/fd,
+  * so the name is only valid in the current process, while the file is open.
+  * \return the file
+  */
+
+OksSystem::File OksSystem::TemporaryFile::file() const {
+    if (! m_name.empty()) return File(m_name,File::LEXICAL);
+    return File("/proc/self/fd/" + std::to_string(fd()),File::LEXICAL);
+} // file
+
+/** Gives a permanent name to the file, the file is then kept after destruction.
+  * A named file is renamed, an anonymous file is linked in the file system.
+  * \param name the name, for an anonymous file it must be in the same file system and must not exist
+  * \exception OksSystem::OksSystemCallIssue if the anonymous file cannot be linked
+  * \exception OksSystem::RenameFileIssue if the named file cannot be renamed
+  */
+
+void OksSystem::TemporaryFile::link(const File &name) {
+    if (m_name.empty()) {
+	const int error = link_descriptor(fd(),name.full_name());
+	if (0!=error) {
+	    std::string message = "on file " + name.full_name();
+	    throw OksSystem::OksSystemCallIssue( ERS_HERE, error, "linkat", message.c_str() );
+	} // if
+    } else if (0!=::rename(m_name.c_str(),name.c_full_name())) {
+	throw OksSystem::RenameFileIssue( ERS_HERE, errno, m_name.c_str(), name.c_full_name() );
+    } // if
+    m_name = name.full_name();
+    m_keep = true;
+} // link
+
+void OksSystem::TemporaryFile::keep() throw() {
+    m_keep = true;
+} // keep
+
+/** Empties the file and rewinds the descriptor, so that the file can be used again
+  * \exception OksSystem::OksSystemCallIssue if the file cannot be truncated
+  */
+
+void OksSystem::TemporaryFile::reset() {
+    if (0!=::ftruncate(fd(),0) || ::lseek(fd(),0,SEEK_SET)<0) {
+	std::string message = "on temporary file in " + m_directory;
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "ftruncate", message.c_str() );
+    } // if
+} // reset
+
+/** Builds a pool, no file is created until \c fill() or \c take() is called
+  * \param directory the directory of the files
+  * \param prefix prefix of the names of named files
+  * \param capacity maximum number of files kept ready
+  * \param named do the files need a name
+  */
+
+OksSystem::TemporaryFilePool::TemporaryFilePool(const File &directory, const std::string &prefix, size_t capacity, bool named) {
+    m_directory = directory.full_name();
+    m_prefix = prefix;
+    m_capacity = capacity;
+    m_named = named;
+} // TemporaryFilePool
+
+/** Destructor, the files still in the pool are closed and removed */
+
+OksSystem::TemporaryFilePool::~TemporaryFilePool() {
+} // ~TemporaryFilePool
+
+OksSystem::TemporaryFile *OksSystem::TemporaryFilePool::create() const {
+    return new TemporaryFile(File(m_directory,File::LEXICAL),m_prefix,m_named);
+} // create
+
+/** Gets an empty file, from the pool if possible, else a new one
+  * \return the file
+  * \exception OksSystem::OpenFileIssue if a new file cannot be created
+  */
+
+OksSystem::TemporaryFile OksSystem::TemporaryFilePool::take() {
+    std::unique_ptr<TemporaryFile> file;
+    {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (! m_files.empty()) {
+	    file.swap(m_files.back());
+	    m_files.pop_back();
+	} // if
+    }
+    if (! file) file.reset(create());
+    return TemporaryFile(std::move(*file));
+} // take
+
+/** Gives a file back to the pool.
+  * The file is emptied and kept for a later \c take(), unless the pool is full,
+  * the file was given a permanent name or belongs to another directory, it is then simply released.
+  * \param file the file
+  */
+
+void OksSystem::TemporaryFilePool::recycle(TemporaryFile &&file) {
+    std::unique_ptr<TemporaryFile> recycled(new TemporaryFile(std::move(file)));
+    if (! recycled->is_open() || recycled->is_kept() || recycled->directory()!=m_directory) return;
+    try {
+	recycled->reset();
+    } catch (ers::Issue &) {
+	return;
+    } // catch
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_files.size()<m_capacity) m_files.push_back(std::move(recycled));
+} // recycle
+
+/** Creates files ahead of time, up to the capacity of the pool
+  * \param count the number of files wanted in the pool
+  * \exception OksSystem::OpenFileIssue if a file cannot be created
+  */
+
+void OksSystem::TemporaryFilePool::fill(size_t count) {
+    if (count>m_capacity) count = m_capacity;
+    while(size()<count) {
+	std::unique_ptr<TemporaryFile> file(create());
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_files.push_back(std::move(file));
+    } // while
+} // fill
+
+size_t OksSystem::TemporaryFilePool::size() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_files.size();
+} // size
+
+size_t OksSystem::TemporaryFilePool::capacity() const throw() {
+    return m_capacity;
+} // capacity
@@ -0,0 +1,219 @@
+/*
+ *  TreeRemover.cxx
+ *  OksSystem
+ *
+ *  Parallel recursive deletion of directory trees.
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "ers/ers.hpp"
+
+#include "okssystem/TreeRemover.hpp"
+#include "okssystem/DirectoryIterator.hpp"
+#include "okssystem/File.hpp"
+#include "okssystem/WorkerPool.hpp"
+#include "okssystem/exceptions.hpp"
+
+namespace {
+
+    typedef std::chrono::steady_clock clock_type ;
+
+    inline uint64_t elapsed_ns(const clock_type::time_point &start, const clock_type::time_point &stop) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(stop-start).count();
+    } // elapsed_ns
+
+    /** A directory being deleted.
+      * The directory stays open until all its subdirectories are gone,
+      * so that they can be opened and removed relative to it.
+      */
+
+    struct Node {
+	std::shared_ptr<Node> parent ;                            // null for the root
+	std::string name ;                                        // name relative to the parent (full path for the root)
+	std::string path ;                                        // full path, for messages
+	int fd ;                                                  // descriptor of the directory, once open
+	std::atomic<int> pending ;                                // scan of this directory + subdirectories not yet removed
+	bool failed ;                                             // could not be read, do not try to remove it
+	Node(const std::shared_ptr<Node> &p, const std::string &n, const std::string &full) : parent(p), name(n), path(full), fd(-1), pending(1), failed(false) {}
+    } ; // Node
+
+    typedef std::shared_ptr<Node> node_ptr ;
+
+    /** State shared by all the workers of one deletion */
+
+    class RemoveContext {
+    public:
+	OksSystem::WorkerPool *m_pool ;
+	std::atomic<size_t> m_files ;
+	std::atomic<size_t> m_directories ;
+	std::atomic<size_t> m_bytes ;
+	std::atomic<uint64_t> m_scan_ns ;
+	std::atomic<uint64_t> m_unlink_ns ;
+	std::atomic<uint64_t> m_rmdir_ns ;
+	std::mutex m_error_mutex ;
+	std::exception_ptr m_error ;
+
+	RemoveContext(OksSystem::WorkerPool *pool) : m_pool(pool), m_files(0), m_directories(0), m_bytes(0), m_scan_ns(0), m_unlink_ns(0), m_rmdir_ns(0) {}
+
+	/** Records an error, only the first one is reported */
+	void fail(const std::exception_ptr &error) {
+	    std::lock_guard<std::mutex> lock(m_error_mutex);
+	    if (! m_error) m_error = error;
+	} // fail
+
+	/** Processes a directory in the pool if there is spare capacity, inline otherwise */
+	void schedule(const node_ptr &node) {
+	    if (m_pool && m_pool->pending() < 2 * m_pool->size()) {
+		m_pool->submit([this, node]() { process(node); });
+	    } else {
+		process(node);
+	    }
+	} // schedule
+
+	/** Reads a directory, deletes the files it contains and schedules the subdirectories */
+	void process(const node_ptr &node) {
+	    const int parent_fd = node->parent ? node->parent->fd : AT_FDCWD;
+	    uint64_t scan_ns = 0;
+	    uint64_t unlink_ns = 0;
+	    std::unique_ptr<OksSystem::DirectoryIterator> listing;
+	    try {
+		listing.reset(new OksSystem::DirectoryIterator(parent_fd,node->name,node->path));
+		node->fd = listing->fd();
+		clock_type::time_point start = clock_type::now();
+		for(const OksSystem::DirectoryEntry *entry = listing->next(); entry; entry = listing->next()) {
+		    const clock_type::time_point read = clock_type::now();
+		    scan_ns += elapsed_ns(start,read);
+		    if (entry->is_directory()) {
+			const node_ptr child(new Node(node,entry->name(),entry->full_name()));
+			node->pending++;
+			schedule(child);
+		    } else {
+			struct stat entry_status;
+			size_t size = 0;
+			if (0==::fstatat(node->fd,entry->name().c_str(),&entry_status,AT_SYMLINK_NOFOLLOW)) {
+			    size = entry_status.st_size;
+			} // if
+			if (0==::unlinkat(node->fd,entry->name().c_str(),0)) {
+			    m_files++;
+			    m_bytes += size;
+			} else if (errno!=ENOENT) {
+			    const std::string path = entry->full_name();
+			    fail(std::make_exception_ptr(OksSystem::RemoveFileIssue( ERS_HERE, errno, path.c_str() )));
+			} // if
+			unlink_ns += elapsed_ns(read,clock_type::now());
+		    } // if
+		    start = clock_type::now();
+		} // for
+	    } catch (...) {
+		node->failed = true;
+		fail(std::current_exception());
+	    } // catch
+	    if (listing) {
+		listing->release(); // the descriptor is closed once all subdirectories are gone
+	    } // if
+	    m_scan_ns += scan_ns;
+	    m_unlink_ns += unlink_ns;
+	    release(node);
+	} // process
+
+	/** Signals that the scan or a subdirectory of a directory is done, removes it when nothing is left */
+	void release(const node_ptr &node) {
+	    if (--(node->pending) > 0) return;
+	    if (node->fd>=0) {
+		::close(node->fd);
+	    } // if
+	    if (! node->failed) {
+		const clock_type::time_point start = clock_type::now();
+		const int parent_fd = node->parent ? node->parent->fd : AT_FDCWD;
+		if (0==::unlinkat(parent_fd,node->name.c_str(),AT_REMOVEDIR)) {
+		    m_directories++;
+		} else if (errno!=ENOENT) {
+		    std::string message = "on directory " + node->path;
+		    fail(std::make_exception_ptr(OksSystem::OksSystemCallIssue( ERS_HERE, errno, "rmdir", message.c_str() )));
+		} // if
+		m_rmdir_ns += elapsed_ns(start,clock_type::now());
+	    } // if
+	    if (node->parent) release(node->parent);
+	} // release
+    } ; // RemoveContext
+
+} // anonymous namespace
+
+OksSystem::TreeRemover::Statistics::Statistics() throw() {
+    files = 0;
+    directories = 0;
+    bytes = 0;
+    scan_time = 0.0;
+    unlink_time = 0.0;
+    rmdir_time = 0.0;
+    elapsed_time = 0.0;
+} // Statistics
+
+/** Constructor
+  * \param workers number of threads used to delete subtrees in parallel,
+  *        0 means one per hardware thread, 1 means everything is done in the calling thread
+  */
+
+OksSystem::TreeRemover::TreeRemover(unsigned int workers) {
+    m_workers = (0==workers) ? WorkerPool::default_size() : workers;
+} // TreeRemover
+
+/** Deletes a file, or a directory and everything it contains.
+  * Symbolic links are deleted, never followed, even if \c root is one.
+  * Deletion continues after an error, the first error is reported once everything else is done.
+  * \param root the file or directory to delete
+  * \return statistics about the deletion
+  * \exception OksSystem::RemoveFileIssue if a file cannot be deleted
+  * \exception OksSystem::OksSystemCallIssue if a directory cannot be read or deleted
+  */
+
+OksSystem::TreeRemover::Statistics OksSystem::TreeRemover::remove(const File &root) const {
+    const clock_type::time_point start = clock_type::now();
+    Statistics statistics;
+    struct stat root_status;
+    if (0!=::lstat(root.c_full_name(),&root_status)) {
+	std::string message = "on file/directory " + root.full_name();
+	throw OksSystem::OksSystemCallIssue( ERS_HERE, errno, "lstat", message.c_str() );
+    } // if
+    if (! S_ISDIR(root_status.st_mode)) {
+	root.unlink();
+	statistics.files = 1;
+	statistics.bytes = root_status.st_size;
+	statistics.unlink_time = statistics.elapsed_time = elapsed_ns(start,clock_type::now()) * 1e-9;
+	return statistics;
+    } // not a directory
+    const node_ptr root_node(new Node(node_ptr(),root.full_name(),root.full_name()));
+    std::unique_ptr<WorkerPool> pool;
+    if (m_workers>1) {
+	pool.reset(new WorkerPool(m_workers));
+    } // if
+    RemoveContext context(pool.get());
+    context.process(root_node);
+    if (pool) {
+	pool->wait();
+    } // if
+    statistics.files = context.m_files;
+    statistics.directories = context.m_directories;
+    statistics.bytes = context.m_bytes;
+    statistics.scan_time = context.m_scan_ns * 1e-9;
+    statistics.unlink_time = context.m_unlink_ns * 1e-9;
+    statistics.rmdir_time = context.m_rmdir_ns * 1e-9;
+    statistics.elapsed_time = elapsed_ns(start,clock_type::now()) * 1e-9;
+    if (context.m_error) {
+	std::rethrow_exception(context.m_error);
+    } // if
+    return statistics;
+} // remove
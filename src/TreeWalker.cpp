@@ -0,0 +1,347 @@
+/*
+ *  TreeWalker.cxx
+ *  OksSystem
+ *
+ *  Parallel traversal of directory trees with filters.
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+#include "ers/ers.hpp"
+
+#include "okssystem/TreeWalker.hpp"
+#include "okssystem/DirectoryIterator.hpp"
+#include "okssystem/File.hpp"
+#include "okssystem/WorkerPool.hpp"
+#include "okssystem/exceptions.hpp"
+
+namespace {
+
+    /** A directory to read. 
+      * The descriptor of a directory stays open as long as subdirectories 
+      * waiting to be opened relative to it hold a reference on it.
+      */
+
+    struct Node {
+	std::shared_ptr<Node> parent ;                            // null for the root, reset once the directory is open
+	std::string name ;                                        // name relative to the parent (full path for the root)
+	std::string path ;                                        // full path
+	unsigned int depth ;                                      // depth of the directory, 0 for the root
+	int fd ;                                                  // descriptor of the directory, once open
+	Node(const std::shared_ptr<Node> &p, const std::string &n, const std::string &full, unsigned int d) : parent(p), name(n), path(full), depth(d), fd(-1) {}
+	~Node() { if (fd>=0) ::close(fd); }
+    } ; // Node
+
+    typedef std::shared_ptr<Node> node_ptr ;
+
+    /** State shared by all the workers of one walk */
+
+    class WalkContext {
+    public:
+	const OksSystem::TreeWalker &m_walker ;
+	const OksSystem::TreeWalker::callback_t *m_callback ;
+	const OksSystem::TreeWalker::status_callback_t *m_status_callback ;
+	unsigned int m_max_depth ;
+	OksSystem::WorkerPool *m_pool ;
+	std::atomic<size_t> m_directories ;
+	std::atomic<size_t> m_entries ;
+	std::atomic<size_t> m_matches ;
+	std::atomic<size_t> m_stats ;
+	std::atomic<size_t> m_errors ;
+	std::mutex m_error_mutex ;
+	std::exception_ptr m_error ;
+
+	WalkContext(const OksSystem::TreeWalker &walker, const OksSystem::TreeWalker::callback_t *callback, const OksSystem::TreeWalker::status_callback_t *status_callback, unsigned int max_depth, OksSystem::WorkerPool *pool) : 
+	    m_walker(walker), m_callback(callback), m_status_callback(status_callback), m_max_depth(max_depth), m_pool(pool), 
+	    m_directories(0), m_entries(0), m_matches(0), m_stats(0), m_errors(0) {}
+
+	/** Records an error, only the first one is reported */
+	void fail(const std::exception_ptr &error) {
+	    std::lock_guard<std::mutex> lock(m_error_mutex);
+	    if (! m_error) m_error = error;
+	} // fail
+
+	/** Processes a directory in the pool if there is spare capacity, inline otherwise */
+	void schedule(const node_ptr &node) {
+	    if (m_pool && m_pool->pending() < 2 * m_pool->size()) {
+		m_pool->submit([this, node]() { process(node); });
+	    } else {
+		process(node);
+	    }
+	} // schedule
+
+	/** Checks the filters of an entry and passes it to the callback.
+	  * The status of the entry is only obtained, with a single stat relative to the directory, 
+	  * if there are size or time filters or if the callback needs it.
+	  */
+	void select(int dir_fd, const OksSystem::DirectoryEntry &entry, unsigned int depth) {
+	    const char *name = entry.name().c_str();
+	    if (! m_walker.accepts_name(name) || ! m_walker.accepts_type(entry.type())) return;
+	    if (m_status_callback || m_walker.needs_status()) {
+		m_stats++;
+		struct stat raw;
+		if (0!=::fstatat(dir_fd,name,&raw,AT_SYMLINK_NOFOLLOW)) return; // entry is gone
+		const OksSystem::FileStatus status(raw);
+		if (! m_walker.accepts_status(status)) return;
+		m_matches++;
+		if (m_status_callback) {
+		    (*m_status_callback)(entry,status,depth);
+		    return;
+		} // if
+	    } else {
+		m_matches++;
+	    } // if
+	    (*m_callback)(entry,depth);
+	} // select
+
+	/** Reads a directory, reports the selected entries and schedules the subdirectories */
+	void process(const node_ptr &node) {
+	    const int parent_fd = node->parent ? node->parent->fd : AT_FDCWD;
+	    std::unique_ptr<OksSystem::DirectoryIterator> listing;
+	    try {
+		listing.reset(new OksSystem::DirectoryIterator(parent_fd,node->name,node->path));
+		node->fd = listing->fd();
+		node->parent.reset(); // the parent can be closed once all its children are open
+		m_directories++;
+		const unsigned int depth = node->depth+1;
+		for(const OksSystem::DirectoryEntry *entry = listing->next(); entry; entry = listing->next()) {
+		    m_entries++;
+		    select(node->fd,*entry,depth);
+		    if (entry->is_directory() && depth<m_max_depth && ! m_walker.prunes(entry->name().c_str())) {
+			schedule(node_ptr(new Node(node,entry->name(),entry->full_name(),depth)));
+		    } // if
+		} // for
+	    } catch (OksSystem::OksSystemCallIssue &) {
+		m_errors++;
+		if (! m_walker.ignores_errors()) fail(std::current_exception());
+	    } catch (...) {
+		fail(std::current_exception());
+	    } // catch
+	    if (listing) {
+		listing->release(); // the descriptor is closed with the node
+	    } // if
+	} // process
+    } ; // WalkContext
+
+} // anonymous namespace
+
+OksSystem::TreeWalker::Statistics::Statistics() throw() {
+    directories = 0;
+    entries = 0;
+    matches = 0;
+    stats = 0;
+    errors = 0;
+    elapsed_time = 0.0;
+} // Statistics
+
+/** Constructor, by default all entries of the tree are selected
+  * \param workers number of threads used to walk subtrees in parallel,
+  *        0 means one per hardware thread, 1 means everything is done in the calling thread
+  */
+
+OksSystem::TreeWalker::TreeWalker(unsigned int workers) {
+    m_workers = (0==workers) ? WorkerPool::default_size() : workers;
+    m_types = 0;
+    m_max_depth = UINT_MAX;
+    m_min_size = 0;
+    m_max_size = (size_t) -1;
+    m_modified_after = 0;
+    m_modified_before = 0;
+    m_ignore_errors = false;
+} // TreeWalker
+
+/** Selects entries whose name matches a glob pattern (see \c fnmatch).
+  * If several patterns are given, entries matching any of them are selected. 
+  * \param pattern the pattern, for instance \c "*.xml"
+  * \return the walker
+  */
+
+OksSystem::TreeWalker & OksSystem::TreeWalker::name(const std::string &pattern) {
+    m_names.push_back(pattern);
+    return *this;
+} // name
+
+/** Prevents the walk from descending into directories whose name matches a glob pattern.
+  * The directory itself can still be selected. 
+  * \param pattern the pattern, for instance \c ".git"
+  * \return the walker
+  */
+
+OksSystem::TreeWalker & OksSystem::TreeWalker::prune(const std::string &pattern) {
+    m_prune.push_back(pattern);
+    return *this;
+} // prune
+
+/** Selects entries of a given type, if called several times, entries of any of the types are selected.
+  * \param type the type 
+  * \return the walker
+  */
+
+OksSystem::TreeWalker & OksSystem::TreeWalker::type(DirectoryEntry::type_t type) {
+    m_types |= (1u << type);
+    return *this;
+} // type
+
+/** Limits the depth of the walk, the entries of the root directory have depth 1
+  * \param depth the maximum depth
+  * \return the walker
+  */
+
+OksSystem::TreeWalker & OksSystem::TreeWalker::max_depth(unsigned int depth) {
+    m_max_depth = depth;
+    return *this;
+} // max_depth
+
+OksSystem::TreeWalker & OksSystem::TreeWalker::min_size(size_t size) {
+    m_min_size = size;
+    return *this;
+} // min_size
+
+OksSystem::TreeWalker & OksSystem::TreeWalker::max_size(size_t size) {
+    m_max_size = size;
+    return *this;
+} // max_size
+
+OksSystem::TreeWalker & OksSystem::TreeWalker::modified_after(time_t time) {
+    m_modified_after = time;
+    return *this;
+} // modified_after
+
+OksSystem::TreeWalker & OksSystem::TreeWalker::modified_before(time_t time) {
+    m_modified_before = time;
+    return *this;
+} // modified_before
+
+/** \param ignore if \c true, directories that cannot be read are counted in the statistics but not reported as errors
+  * \return the walker
+  */
+
+OksSystem::TreeWalker & OksSystem::TreeWalker::ignore_errors(bool ignore) {
+    m_ignore_errors = ignore;
+    return *this;
+} // ignore_errors
+
+bool OksSystem::TreeWalker::ignores_errors() const throw() {
+    return m_ignore_errors;
+} // ignores_errors
+
+bool OksSystem::TreeWalker::accepts_name(const char *name) const throw() {
+    if (m_names.empty()) return true;
+    for(size_t i=0;i<m_names.size();i++) {
+	if (0==::fnmatch(m_names[i].c_str(),name,FNM_PERIOD)) return true;
+    } // for
+    return false;
+} // accepts_name
+
+bool OksSystem::TreeWalker::accepts_type(DirectoryEntry::type_t type) const throw() {
+    return (0==m_types) || (m_types & (1u << type))!=0;
+} // accepts_type
+
+/** Checks the size and time filters
+  * \param status the status of the entry
+  * \return \c true if the entry passes the filters
+  */
+
+bool OksSystem::TreeWalker::accepts_status(const FileStatus &status) const throw() {
+    if (status.size()<m_min_size || status.size()>m_max_size) return false;
+    const time_t modified = status.modification_time().tv_sec;
+    if (m_modified_after && modified<m_modified_after) return false;
+    if (m_modified_before && modified>=m_modified_before) return false;
+    return true;
+} // accepts_status
+
+bool OksSystem::TreeWalker::prunes(const char *name) const throw() {
+    for(size_t i=0;i<m_prune.size();i++) {
+	if (0==::fnmatch(m_prune[i].c_str(),name,0)) return true;
+    } // for
+    return false;
+} // prunes
+
+/** \return \c true if the size or time filters are set, they need a \c statx for each entry */
+
+bool OksSystem::TreeWalker::needs_status() const throw() {
+    return m_min_size>0 || m_max_size!=(size_t) -1 || m_modified_after || m_modified_before;
+} // needs_status
+
+/** Walks a directory tree.
+  * The walk continues after an error, the first error is reported once everything else is done,
+  * unless errors are ignored. 
+  * \param root the directory to walk, it is not itself passed to the callback
+  * \param callback function called for each selected entry, concurrently from several threads
+  * \return statistics about the walk
+  * \exception OksSystem::OksSystemCallIssue if a directory cannot be read
+  * \exception any exception thrown by the callback (the first one)
+  */
+
+OksSystem::TreeWalker::Statistics OksSystem::TreeWalker::walk(const File &root, const callback_t &callback) const {
+    return walk(root,&callback,0);
+} // walk
+
+/** Walks a directory tree, passing the status of each selected entry to the callback.
+  * This costs one \c fstatat per selected entry. 
+  * \param root the directory to walk, it is not itself passed to the callback
+  * \param callback function called for each selected entry, concurrently from several threads
+  * \return statistics about the walk
+  * \exception OksSystem::OksSystemCallIssue if a directory cannot be read
+  * \exception any exception thrown by the callback (the first one)
+  */
+
+OksSystem::TreeWalker::Statistics OksSystem::TreeWalker::walk(const File &root, const status_callback_t &callback) const {
+    return walk(root,0,&callback);
+} // walk
+
+/** Walks a directory tree, exactly one of the callbacks is not null */
+
+OksSystem::TreeWalker::Statistics OksSystem::TreeWalker::walk(const File &root, const callback_t *callback, const status_callback_t *status_callback) const {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::unique_ptr<WorkerPool> pool;
+    if (m_workers>1) {
+	pool.reset(new WorkerPool(m_workers));
+    } // if
+    WalkContext context(*this,callback,status_callback,m_max_depth,pool.get());
+    if (m_max_depth>0) {
+	context.process(node_ptr(new Node(node_ptr(),root.full_name(),root.full_name(),0)));
+    } // if
+    if (pool) {
+	pool->wait();
+    } // if
+    Statistics statistics;
+    statistics.directories = context.m_directories;
+    statistics.entries = context.m_entries;
+    statistics.matches = context.m_matches;
+    statistics.stats = context.m_stats;
+    statistics.errors = context.m_errors;
+    statistics.elapsed_time = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    if (context.m_error) {
+	std::rethrow_exception(context.m_error);
+    } // if
+    return statistics;
+} // walk
+
+/** Collects the selected entries of a directory tree.
+  * \param root the directory to walk
+  * \return the selected entries, in no particular order
+  * \exception OksSystem::OksSystemCallIssue if a directory cannot be read
+  */
+
+std::vector<OksSystem::DirectoryEntry> OksSystem::TreeWalker::find(const File &root) const {
+    std::mutex mutex;
+    std::vector<DirectoryEntry> entries;
+    walk(root,[&mutex,&entries](const DirectoryEntry &entry, unsigned int) {
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.push_back(entry);
+    });
+    return entries;
+} // find
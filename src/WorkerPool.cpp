@@ -0,0 +1,163 @@
+/*
+ *  WorkerPool.cxx
+ *  OksSystem
+ *
+ *  Bounded pool of threads executing tasks.
+ *
+ */
+
+#include "okssystem/WorkerPool.hpp"
+
+namespace {
+
+    /** Pool and queue of the worker running in the current thread, if any */
+    thread_local OksSystem::WorkerPool *s_current_pool = 0;
+    thread_local size_t s_current_queue = 0;
+
+} // anonymous namespace
+
+/** \return the number of threads the hardware can run concurrently (at least 1) */
+
+unsigned int OksSystem::WorkerPool::default_size() throw() {
+    const unsigned int n = std::thread::hardware_concurrency();
+    return (n>0) ? n : 1;
+} // default_size
+
+/** Constructor, starts the worker threads
+  * \param workers number of threads, 0 means \c default_size()
+  */
+
+OksSystem::WorkerPool::WorkerPool(unsigned int workers) {
+    m_queued = 0;
+    m_active = 0;
+    m_next_queue = 0;
+    m_stop = false;
+    if (0==workers) workers = default_size();
+    for(unsigned int i=0;i<workers;i++) {
+	m_queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    } // for
+    for(unsigned int i=0;i<workers;i++) {
+	m_threads.push_back(std::thread(&WorkerPool::run,this,i));
+    } // for
+} // WorkerPool
+
+/** Destructor, waits for the queued tasks and stops the threads.
+  * Exceptions thrown by tasks and not collected with \c wait() are discarded.
+  */
+
+OksSystem::WorkerPool::~WorkerPool() {
+    {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idle.wait(lock,[this]{ return 0==m_queued && 0==m_active; });
+	m_stop = true;
+    }
+    m_work.notify_all();
+    for(size_t i=0;i<m_threads.size();i++) {
+	m_threads[i].join();
+    } // for
+} // ~WorkerPool
+
+/** Takes a task for a worker, from the back of its own queue, 
+  * or else from the front of the queue of another worker.
+  * \param index index of the queue of the worker
+  * \param task the task, filled on success
+  * \return \c true if a task was found
+  */
+
+bool OksSystem::WorkerPool::take(size_t index, task_t &task) {
+    {
+	Queue &own = *m_queues[index];
+	std::lock_guard<std::mutex> lock(own.m_mutex);
+	if (! own.m_tasks.empty()) {
+	    task = std::move(own.m_tasks.back());
+	    own.m_tasks.pop_back();
+	    return true;
+	} // if
+    }
+    for(size_t i=1;i<m_queues.size();i++) {
+	Queue &other = *m_queues[(index+i) % m_queues.size()];
+	std::lock_guard<std::mutex> lock(other.m_mutex);
+	if (! other.m_tasks.empty()) {
+	    task = std::move(other.m_tasks.front());
+	    other.m_tasks.pop_front();
+	    return true;
+	} // if
+    } // for
+    return false;
+} // take
+
+void OksSystem::WorkerPool::run(size_t index) {
+    s_current_pool = this;
+    s_current_queue = index;
+    while(true) {
+	task_t task;
+	if (! take(index,task)) {
+	    std::unique_lock<std::mutex> lock(m_mutex);
+	    m_work.wait(lock,[this]{ return m_stop || m_queued>0; });
+	    if (m_stop && 0==m_queued) return;
+	    continue;
+	} // if
+	{
+	    std::lock_guard<std::mutex> lock(m_mutex);
+	    m_queued--;
+	    m_active++;
+	}
+	try {
+	    task();
+	} catch (...) {
+	    std::lock_guard<std::mutex> lock(m_mutex);
+	    if (! m_error) m_error = std::current_exception();
+	} // catch
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_active--;
+	if (0==m_queued && 0==m_active) m_idle.notify_all();
+    } // while
+} // run
+
+/** Queues a task.
+  * A task submitted by a task running in the pool goes to the queue of the same worker, 
+  * which runs the most recent tasks of its queue first, idle workers steal the oldest tasks of other queues.
+  * For recursive work this keeps each worker on its own subtree and hands out large subtrees to idle workers.
+  * Tasks submitted from other threads are spread over the queues.
+  * \param task the task to run
+  */
+
+void OksSystem::WorkerPool::submit(const task_t &task) {
+    const size_t index = (s_current_pool==this) ? s_current_queue : (m_next_queue++ % m_queues.size());
+    {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_queued++; // counted first, so that it never drops below the number of queued tasks
+    }
+    {
+	Queue &queue = *m_queues[index];
+	std::lock_guard<std::mutex> lock(queue.m_mutex);
+	queue.m_tasks.push_back(task);
+    }
+    m_work.notify_one();
+} // submit
+
+/** Waits until all the tasks are finished.
+  * This must not be called from a task running in the pool.
+  * \exception any exception thrown by a task (the first one)
+  */
+
+void OksSystem::WorkerPool::wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock,[this]{ return 0==m_queued && 0==m_active; });
+    if (m_error) {
+	std::exception_ptr error = m_error;
+	m_error = std::exception_ptr();
+	std::rethrow_exception(error);
+    } // if
+} // wait
+
+/** \return the number of tasks waiting for a free worker */
+
+size_t OksSystem::WorkerPool::pending() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queued;
+} // pending
+
+unsigned int OksSystem::WorkerPool::size() const throw() {
+    return m_threads.size();
+} // size
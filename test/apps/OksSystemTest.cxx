@@ -11,9 +11,15 @@
  */
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unordered_set>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <errno.h>
 
 #include "ers/ers.hpp"
 #include "logging/Logging.hpp"
@@ -50,6 +56,21 @@ void test_write_chmod(const OksSystem::File &file) {
     } 
 } // text_exec
 
+void test_status(const OksSystem::File &file) {
+  TLOG_DEBUG( 1) << "Testing OksSystem::File::status " << file.c_full_name();
+    const OksSystem::FileStatus status = file.status();
+    if (! status.is_regular() || status.size()!=file.size() || status.permissions()!=file.permissions()) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Status check: fail")));
+	exit (183);
+    }
+    TLOG_DEBUG( 1) << "Status check: ok, size " << status.size() << " owner " << status.owner_id();
+    const OksSystem::FileStatus partial = file.query(OksSystem::FileStatus::TYPE | OksSystem::FileStatus::SIZE, OksSystem::File::SYNC_DONT);
+    if (! partial.has(OksSystem::FileStatus::TYPE | OksSystem::FileStatus::SIZE) || partial.size()!=status.size()) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Query check: fail")));
+	exit (183);
+    }
+} // test_status
+
 int test_exec(const OksSystem::Executable &executable, int status ) {
   TLOG_DEBUG( 1) << "Testing OksSystem::Executable::start \"" << executable.c_full_name() << "\" parameter: " << status; 
     std::vector<std::string> params;
@@ -81,11 +102,488 @@ void test_mkdir(const OksSystem::File &file) {
     TLOG_DEBUG( 1) << "Directory depth is " << file.depth();
 } //test_mkdir
 
+void test_entries(const OksSystem::File &dir, const std::string &name) {
+  TLOG_DEBUG( 1) << "Listing directory " << dir.c_full_name(); 
+    const OksSystem::File::entry_list_t entries = dir.entries();
+    for(OksSystem::File::entry_list_t::const_iterator pos = entries.begin(); pos!=entries.end(); pos++) {
+	if (pos->name()==name && pos->is_directory()) {
+	    TLOG_DEBUG( 1) << "Found entry " << pos->full_name() << " inode " << pos->inode(); 
+	    OksSystem::DirectoryIterator listing(dir);
+	    for(const OksSystem::DirectoryEntry &entry : listing) {
+		if (entry.inode()==pos->inode()) return; 
+	    } // for
+	    break;
+	} 
+    } // for
+    ers::warning(OksSystem::Exception(ERS_HERE, std::string("Directory entry check: fail")));
+    exit (183);
+} // test_entries
+
+void test_find(const OksSystem::File &dir) {
+  TLOG_DEBUG( 1) << "Testing tree walker on " << dir.c_full_name(); 
+    const OksSystem::File::entry_list_t data = dir.find("data");
+    std::atomic<size_t> shallow(0);
+    OksSystem::TreeWalker walker;
+    walker.type(OksSystem::DirectoryEntry::DIRECTORY).max_depth(2).prune("sub3");
+    const OksSystem::TreeWalker::Statistics statistics = walker.walk(dir,[&shallow](const OksSystem::DirectoryEntry &, unsigned int) { shallow++; });
+    const OksSystem::DiskUsage usage = dir.disk_usage();
+    if (data.size()!=8 || shallow!=15 || statistics.directories!=8 
+	|| usage.total().files!=8 || usage.total().directories!=17 || usage.entries().size()!=8 || usage.errors()!=0) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Tree walker check: fail")));
+	exit (183);
+    }
+} // test_find
+
+void test_directory_index(const OksSystem::File &dir) {
+  TLOG_DEBUG( 1) << "Testing directory index of " << dir.c_full_name(); 
+    const OksSystem::File index_file("/tmp/okssystem_index", OksSystem::File::LEXICAL);
+    OksSystem::DirectoryIndex index(dir,index_file);
+    const OksSystem::DirectoryIndex::Statistics first = index.update();
+    // the tree was just created, its directories are read again until their times are older than an update
+    std::this_thread::sleep_for(std::chrono::nanoseconds(OksSystem::FileFingerprint::RACY_NS));
+    const OksSystem::DirectoryIndex::Statistics racy = index.update();
+    const OksSystem::DirectoryIndex::Statistics second = index.update();
+    const bool unchanged = first.written && racy.directories_read==17 && racy.written 
+	&& ! second.written && second.directories_read==0 && index.size()==24 && index.directory_count()==17;
+    const OksSystem::File extra = dir.child("sub3/leaf/extra");
+    extra.atomic_write(std::string_view("extra\n"));
+    const OksSystem::DirectoryIndex::Statistics third = index.update();
+    bool found = false;
+    for(size_t i=0;i<index.size();i++) {
+	const OksSystem::DirectoryIndex::Entry entry = index.entry(i);
+	if (entry.name=="extra" && entry.full_name()==extra.full_name() && entry.size==6) found = true;
+    } // for
+    const OksSystem::DirectoryIndex reloaded(dir,index_file);
+    const bool ok = unchanged && third.written && third.directories_read==1 && third.directories_checked==17 && index.size()==25 
+	&& found && reloaded.is_loaded() && reloaded.size()==25;
+    extra.unlink();
+    index_file.unlink();
+    if (! ok) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Directory index check: fail")));
+	exit (183);
+    }
+} // test_directory_index
+
+void test_copy(const OksSystem::File &dir) {
+  TLOG_DEBUG( 1) << "Testing file copy"; 
+    const OksSystem::File source = dir.child("okssystem_copy_source", OksSystem::File::LEXICAL);
+    const OksSystem::File copy = dir.child("okssystem_copy", OksSystem::File::LEXICAL);
+    const OksSystem::File moved = dir.child("okssystem_moved", OksSystem::File::LEXICAL);
+    std::ostream *stream = source.output();
+    for(int i=0;i<10000;i++) *stream << "line " << i << std::endl;
+    delete stream;
+    source.permissions(0640);
+    const OksSystem::FileCopier::Statistics statistics = source.copy_to(copy);
+    const OksSystem::FileCopier::Statistics buffered = OksSystem::FileCopier(OksSystem::FileCopier::progress_t(),OksSystem::FileCopier::BUFFERED).copy(source,moved);
+    copy.move_to(moved);
+    TLOG_DEBUG( 1) << "Copied " << statistics.bytes << " bytes with " << OksSystem::FileCopier::method_name(statistics.method); 
+    const bool same_content = statistics.bytes==source.size() && source.content().view()==moved.content().view();
+    bool self_refused = false;
+    try {
+	moved.copy_to(moved);
+    } catch (OksSystem::OksSystemCallIssue &ex) {
+	self_refused = true;
+    }
+    const bool self_kept = source.content().view()==moved.content().view();
+    bool interrupted = false;
+    try {
+	OksSystem::FileCopier([](size_t, size_t) { throw std::runtime_error("interrupted"); },OksSystem::FileCopier::BUFFERED).copy(source,moved);
+    } catch (std::runtime_error &ex) {
+	interrupted = source.content().view()==moved.content().view();
+    }
+    for(const OksSystem::DirectoryEntry &entry : dir.entries()) {
+	if (0==entry.name().compare(0,17,".okssystem_moved.")) interrupted = false; // temporary file left
+    }
+    bool link_moved = true;
+    struct stat dir_status, shm_status;
+    if (0==::stat(dir.c_full_name(),&dir_status) && 0==::stat("/dev/shm",&shm_status) && dir_status.st_dev!=shm_status.st_dev) {
+	const OksSystem::File link = dir.child("okssystem_copy_link", OksSystem::File::LEXICAL);
+	const OksSystem::File moved_link("/dev/shm/okssystem_copy_link", OksSystem::File::LEXICAL);
+	link_moved = 0==::symlink(source.c_full_name(),link.c_full_name());
+	link.move_to(moved_link);
+	link_moved = link_moved && ! link.exists() && moved_link.is_symlink() && moved_link.link_target()==source.full_name();
+	moved_link.unlink();
+    }
+    const size_t sparse_size = 8*1024*1024;
+    const int fd = ::open(source.c_full_name(),O_WRONLY | O_TRUNC);
+    const bool sparse_written = fd>=0 && 0==::ftruncate(fd,sparse_size) && 4==::pwrite(fd,"data",4,sparse_size/2);
+    if (fd>=0) ::close(fd);
+    const OksSystem::FileCopier::Statistics sparse = source.copy_to(moved);
+    struct stat sparse_status;
+    const bool holes_kept = sparse_written && 0==::stat(moved.c_full_name(),&sparse_status) && (size_t) sparse_status.st_size==sparse_size
+	&& (size_t) sparse_status.st_blocks*512<sparse_size/2 && source.content().view()==moved.content().view();
+    TLOG_DEBUG( 1) << "Sparse copy: " << sparse.data_bytes << " data bytes, " << sparse_status.st_blocks << " blocks"; 
+    const bool ok = buffered.method==OksSystem::FileCopier::BUFFERED 
+	&& ! copy.exists() && moved.permissions()==0640 && same_content && self_refused && self_kept && interrupted && link_moved && holes_kept;
+    source.unlink();
+    moved.unlink();
+    if (! ok) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("File copy check: fail")));
+	exit (183);
+    }
+} // test_copy
+
+void test_content(const OksSystem::File &file) {
+  TLOG_DEBUG( 1) << "Testing file content"; 
+    std::ostringstream text;
+    for(int i=0;i<5000;i++) text << "line " << i << std::endl;
+    std::ostream *stream = file.output();
+    *stream << text.str();
+    delete stream;
+    const OksSystem::FileContent read = file.content();
+    const OksSystem::FileContent mapped = file.content(1);
+    const OksSystem::FileContent proc = OksSystem::File("/proc/self/status").content();
+    TLOG_DEBUG( 1) << "Read " << read.size() << " bytes, mapped " << mapped.size() << " bytes"; 
+    const bool ok = ! read.is_mapped() && mapped.is_mapped() && read.view()==text.str() && mapped.view()==text.str()
+	&& ! proc.empty() && proc.view().find("Pid:")!=std::string_view::npos;
+    file.unlink();
+    if (! ok) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("File content check: fail")));
+	exit (183);
+    }
+} // test_content
+
+void test_atomic_write(const OksSystem::File &file) {
+  TLOG_DEBUG( 1) << "Testing atomic write"; 
+    file.atomic_write(std::string_view("first version\n"),0640);
+    OksSystem::AtomicWriter::SyncBatch batch;
+    {
+	OksSystem::AtomicWriter writer = file.atomic_writer(0600,&batch);
+	writer.write(std::string_view("dropped\n"));
+    }
+    const bool kept = file.content().view()=="first version\n";
+    OksSystem::AtomicWriter writer = file.atomic_writer(0600,&batch);
+    writer.write(std::string_view("second "));
+    writer.write(std::string_view("version\n"));
+    writer.commit();
+    TLOG_DEBUG( 1) << "Atomic write anonymous: " << writer.is_anonymous(); 
+    bool ok = kept && file.content().view()=="second version\n" && file.permissions()==0600 && batch.size()==1;
+    batch.sync();
+    file.atomic_write(std::string_view("third version\n"));
+    ok = ok && file.permissions()==0600;
+    file.unlink();
+    const mode_t mask = ::umask(022);
+    file.atomic_write(std::string_view("new file\n"));
+    ok = ok && file.permissions()==0644;
+    ::umask(mask);
+    file.unlink();
+    if (! ok) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Atomic write check: fail")));
+	exit (183);
+    }
+} // test_atomic_write
+
+void test_descriptor_stream(const OksSystem::File &file) {
+  TLOG_DEBUG( 1) << "Testing descriptor streams"; 
+    OksSystem::DescriptorStreamBuf::Options options(4096);
+    OksSystem::DescriptorOutputStream *output = file.output(false,options);
+    for(int i=0;i<10000;i++) *output << "line " << i << '\n';
+    output->close();
+    delete output;
+    std::string line;
+    int count = 0;
+    OksSystem::DescriptorInputStream *input = file.input(options);
+    while(std::getline(*input,line)) count++;
+    const bool closed = (fcntl(input->fd(),F_GETFD) & FD_CLOEXEC)!=0;
+    input->clear();
+    input->seekg(5);
+    std::getline(*input,line);
+    delete input;
+    TLOG_DEBUG( 1) << "Read " << count << " lines"; 
+    const bool ok = count==10000 && closed && line=="0" && file.content().size()==file.size();
+    file.unlink();
+    if (! ok) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Descriptor stream check: fail")));
+	exit (183);
+    }
+} // test_descriptor_stream
+
+void test_temporary(const OksSystem::File &dir) {
+  TLOG_DEBUG( 1) << "Testing temporary files"; 
+    OksSystem::TemporaryFile anonymous = dir.make_temporary("okssystem_tmp");
+    anonymous.descriptor().write("data",4);
+    const bool anonymous_ok = anonymous.file().size()==4;
+    std::string name;
+    {
+	OksSystem::TemporaryFile named = dir.make_temporary("okssystem_tmp",true);
+	name = named.file().full_name();
+	named.descriptor().write("data",4);
+    }
+    const bool named_ok = ! name.empty() && ! OksSystem::File(name).exists();
+    const OksSystem::File linked = dir.child("okssystem_tmp_linked", OksSystem::File::LEXICAL);
+    anonymous.link(linked);
+    const bool linked_ok = linked.exists() && linked.size()==4;
+    linked.unlink();
+    OksSystem::TemporaryFilePool pool(dir,"okssystem_pool",4);
+    pool.fill(2);
+    OksSystem::TemporaryFile scratch = pool.take();
+    scratch.descriptor().write("data",4);
+    pool.recycle(std::move(scratch));
+    OksSystem::TemporaryFile reused = pool.take();
+    const bool pool_ok = pool.size()==1 && reused.file().size()==0;
+    TLOG_DEBUG( 1) << "Temporary files anonymous: " << reused.is_anonymous(); 
+    if (! (anonymous_ok && named_ok && linked_ok && pool_ok)) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Temporary file check: fail")));
+	exit (183);
+    }
+} // test_temporary
+
+void test_watcher(const OksSystem::File &dir) {
+  TLOG_DEBUG( 1) << "Testing file watcher"; 
+    dir.make_dir(0755);
+    const OksSystem::File file = dir.child("raw_file", OksSystem::File::LEXICAL);
+    OksSystem::FileWatcher watcher;
+    watcher.watch(dir);
+    std::ostream *stream = file.output();
+    *stream << "data" << std::endl;
+    delete stream;
+    const bool written = watcher.wait_for(file,OksSystem::FileWatcher::CLOSED_WRITE,2000);
+    std::atomic<unsigned int> seen(0);
+    watcher.start([&seen,&file,&watcher](const OksSystem::FileWatcher::Event &event) {
+	if (! event.file.equals(file)) return;
+	seen |= event.events;
+	if (event.has(OksSystem::FileWatcher::DELETED)) watcher.stop(); // stopped from the callback
+	throw std::runtime_error("reported as a warning");
+    });
+    file.unlink();
+    for(int i=0;i<200 && 0==(seen & OksSystem::FileWatcher::DELETED);i++) usleep(10000);
+    watcher.stop();
+    TLOG_DEBUG( 1) << "Watcher events: " << seen; 
+    dir.remove();
+    if (! written || 0==(seen & OksSystem::FileWatcher::DELETED)) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("File watcher check: fail")));
+	exit (183);
+    }
+} // test_watcher
+
+void test_line_reader(const OksSystem::File &file) {
+  TLOG_DEBUG( 1) << "Testing line reader"; 
+    std::ostream *stream = file.output();
+    for(int i=0;i<1000;i++) *stream << "line " << i << '\n';
+    *stream << std::string(5000,'x') << '\n' << '\n' << "last";
+    delete stream;
+    std::string_view line;
+    OksSystem::LineReader memory(file);
+    size_t memory_bytes = 0;
+    while(memory.next(line)) memory_bytes += line.size();
+    OksSystem::LineReader block(file,OksSystem::LineReader::BLOCK,64);
+    size_t block_bytes = 0;
+    bool last = false;
+    while(block.next(line)) { block_bytes += line.size(); last = (line=="last"); }
+    std::atomic<size_t> parallel_bytes(0);
+    const size_t parallel_lines = OksSystem::LineReader::for_each(file,[&parallel_bytes](std::string_view l, size_t) { parallel_bytes += l.size(); },4);
+    TLOG_DEBUG( 1) << "Read " << memory.line_number() << " lines"; 
+    const bool ok = memory.is_in_memory() && ! block.is_in_memory() && memory.line_number()==1003 && block.line_number()==1003 
+	&& parallel_lines==1003 && last && memory_bytes+1002==file.size() && block_bytes==memory_bytes && parallel_bytes==memory_bytes;
+    file.unlink();
+    if (! ok) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Line reader check: fail")));
+	exit (183);
+    }
+} // test_line_reader
+
+void test_content_hash(const OksSystem::File &file) {
+  TLOG_DEBUG( 1) << "Testing content hash"; 
+    file.atomic_write(std::string_view("abc"));
+    const std::string sha256 = file.hash(OksSystem::ContentHash::SHA256);
+    const std::string xxh64 = file.hash(OksSystem::ContentHash::XXH64);
+    const std::string tree = file.hash(OksSystem::ContentHash::SHA256_TREE);
+    const OksSystem::File files[2] = { file, OksSystem::File("/tmp/okssystem_no_such_file", OksSystem::File::LEXICAL) };
+    const OksSystem::ContentHash::result_list_t results = OksSystem::ContentHash::hash_many(files,2,OksSystem::ContentHash::SHA256,2);
+    TLOG_DEBUG( 1) << "SHA-256 " << sha256 << " XXH64 " << xxh64; 
+    const bool small = sha256=="ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" && xxh64=="44bc2cf5ad770999"
+	&& file.hash(OksSystem::ContentHash::XXH128)=="06b05ab6733a618578af5f94892f3950"
+	&& tree==OksSystem::ContentHash::hash("abc",3,OksSystem::ContentHash::SHA256_TREE) && tree!=sha256
+	&& results.size()==2 && results[0].digest==sha256 && ENOENT==results[1].error;
+    // more than one chunk, and many read buffers
+    std::string data(OksSystem::ContentHash::CHUNK_SIZE+12345,'\0');
+    for(size_t i=0;i<data.size();i++) data[i] = (char) ((i*2654435761ULL) >> 13);
+    file.atomic_write(data);
+    const std::string large_tree = file.hash(OksSystem::ContentHash::XXH128_TREE,4);
+    const OksSystem::File fifo("/tmp/okssystem_hash_fifo", OksSystem::File::LEXICAL);
+    fifo.make_fifo(0600);
+    std::thread writer([&fifo,&data]() {
+	std::ostream *stream = fifo.output();
+	stream->write(data.data(),data.size());
+	delete stream;
+    });
+    const std::string fifo_tree = fifo.hash(OksSystem::ContentHash::XXH128_TREE);
+    writer.join();
+    fifo.unlink();
+    TLOG_DEBUG( 1) << "XXH128 tree " << large_tree; 
+    const bool large = file.hash(OksSystem::ContentHash::SHA256)=="be5d9e55a2bad8f4152a33f569350b873baae15ba523b1849a84fa4a9491279e"
+	&& file.hash(OksSystem::ContentHash::XXH128)=="d4426104854e72ad7638624faf38be20"
+	&& file.hash(OksSystem::ContentHash::XXH64)=="70dc888bea60f38d"
+	&& file.hash(OksSystem::ContentHash::SHA256_TREE,4)==OksSystem::ContentHash::hash(data.data(),data.size(),OksSystem::ContentHash::SHA256_TREE)
+	&& large_tree==OksSystem::ContentHash::hash(data.data(),data.size(),OksSystem::ContentHash::XXH128_TREE) && large_tree==fifo_tree;
+    const bool ok = small && large;
+    file.unlink();
+    if (! ok) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Content hash check: fail")));
+	exit (183);
+    }
+} // test_content_hash
+
 void test_rmdir(const OksSystem::File &file) {
   TLOG_DEBUG( 1) << "Deleting directory " << file.c_full_name(); 
     file.remove(); 
 } // test_rmdir 
 
+void test_remove_tree(const OksSystem::File &dir) {
+  TLOG_DEBUG( 1) << "Deleting directory tree " << dir.c_full_name(); 
+    for(int i=0;i<8;i++) {
+	std::ostringstream name;
+	name << "sub" << i << "/leaf";
+	OksSystem::File leaf = dir.child(name.str());
+	leaf.make_path(0700);
+	std::ostream* stream = leaf.child("data").output();
+	(*stream) << "payload\n";
+	delete(stream); 
+    } // for
+    test_find(dir);
+    test_directory_index(dir);
+    const OksSystem::TreeRemover::Statistics statistics = dir.remove_tree(4);
+    TLOG_DEBUG( 1) << "Removed " << statistics.files << " files, " << statistics.directories << " directories, " 
+		   << statistics.bytes << " bytes in " << statistics.elapsed_time << " s"; 
+    if (dir.exists() || statistics.files!=8 || statistics.directories!=17) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Tree removal check: fail")));
+	exit (183);
+    }
+} // test_remove_tree
+
+void test_lexical() {
+  TLOG_DEBUG( 1) << "Testing lexical file names"; 
+    const OksSystem::File lexical("/tmp/./really//../okssystem_test", OksSystem::File::LEXICAL);
+    if (lexical.full_name()!="/tmp/okssystem_test" || lexical.resolve()!=OksSystem::File("/tmp/okssystem_test")) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Lexical name check: fail")));
+	exit (183);
+    }
+} // test_lexical
+
+void test_file_type() {
+  TLOG_DEBUG( 1) << "Testing file type detection"; 
+    const char script[] = "#!/usr/bin/env python3\nprint(1)\n";
+    const char json[] = "{ \"a\": 1 }\n";
+    const char empty_script[] = "#! \n";
+    char elf[64] = { 0x7f, 'E', 'L', 'F', 2, 1, 1 };              // 64 bits shared object, program headers out of the buffer
+    elf[16] = 3;
+    elf[18] = 62;
+    for(int i=32;i<40;i++) elf[i] = (char) 0xff;
+    elf[32] = (char) 0xfc;
+    elf[54] = 56;
+    elf[56] = 4;
+    if (OksSystem::File::content_type(script,sizeof(script)-1)!="Python script, ASCII text executable"
+	|| OksSystem::File::content_type(json,sizeof(json)-1)!="JSON text data"
+	|| OksSystem::File::content_type(empty_script,sizeof(empty_script)-1).find("script")==std::string::npos
+	|| OksSystem::File::content_type(elf,sizeof(elf))!="ELF 64-bit LSB shared object, x86-64"
+	|| OksSystem::File("/tmp").file_type()!="directory"
+	|| OksSystem::File("/tmp/okssystem_missing", OksSystem::File::LEXICAL).file_type()!="cannot open (No such file or directory)") {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("File type check: fail")));
+	exit (183);
+    }
+} // test_file_type
+
+void test_stat_many() {
+  TLOG_DEBUG( 1) << "Testing batch metadata queries"; 
+    OksSystem::File::file_list_t files;
+    files.push_back(OksSystem::File("/tmp"));
+    files.push_back(OksSystem::File("/tmp/okssystem_missing", OksSystem::File::LEXICAL));
+    files.push_back(OksSystem::File("/"));
+    const OksSystem::File::stat_list_t results = OksSystem::File::stat_many(files, OksSystem::FileStatus::TYPE);
+    const OksSystem::File::stat_list_t cached = OksSystem::File::stat_many(files, OksSystem::FileStatus::TYPE, 2, OksSystem::File::SYNC_DONT);
+    if (results.size()!=3 || results[0].error!=0 || ! results[0].status.is_directory() 
+	|| results[1].error!=ENOENT || results[2].error!=0
+	|| cached.size()!=3 || ! cached[0].status.is_directory() || cached[1].error!=ENOENT) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Batch stat check: fail")));
+	exit (183);
+    }
+} // test_stat_many
+
+void test_file_id(const OksSystem::File &dir) {
+  TLOG_DEBUG( 1) << "Testing file identities"; 
+    const OksSystem::File file = dir.child("identity");
+    const OksSystem::File link = dir.child("identity_link");
+    delete file.output();
+    ::link(file.c_full_name(),link.c_full_name());
+    std::unordered_set<OksSystem::FileId> ids;
+    std::unordered_set<OksSystem::File> files;
+    for(const OksSystem::DirectoryEntry &entry : dir.entries()) {
+	if (entry.name().compare(0,8,"identity")!=0) continue;
+	ids.insert(entry.id());
+	files.insert(entry.file());
+    }
+    const bool ok = (ids.size()==1 && files.size()==2 && *ids.begin()==file.id() && file.id()==link.id());
+    link.unlink();
+    file.unlink();
+    if (! ok) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("File identity check: fail")));
+	exit (183);
+    }
+} // test_file_id
+
+void test_symlink(const OksSystem::File &dir) {
+  TLOG_DEBUG( 1) << "Testing symbolic links"; 
+    const OksSystem::File link = dir.child("okssystem_link", OksSystem::File::LEXICAL);
+    ::symlink("okssystem_target",link.c_full_name());
+    const bool ok = link.is_symlink() && link.link_target()=="okssystem_target" && ! link.exists() && ! OksSystem::File("/tmp").is_symlink();
+    link.unlink();
+    if (! ok) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Symbolic link check: fail")));
+	exit (183);
+    }
+} // test_symlink
+
+void test_filesystem(const OksSystem::File &file) {
+  TLOG_DEBUG( 1) << "Testing file system information"; 
+    const OksSystem::FileSystemInfo info = file.filesystem();
+    TLOG() << "File system of " << file.c_full_name() << " is " << info.type_name() << ", " 
+	   << OksSystem::File::pretty_size(info.available_bytes(),true) << " available" ; 
+    const size_t reserved = 8*1024*1024;
+    file.atomic_write(std::string_view("previous content, longer than the new one\n"));
+    std::ostream *stream = file.output(false,reserved);
+    *stream << "data" << std::endl;
+    delete stream;
+    struct stat status;
+    const bool released = 0==::stat(file.c_full_name(),&status) && (size_t) status.st_blocks*512<reserved/2;
+    if (info.block_size()==0 || info.total_bytes()<info.free_bytes() || file.size()!=5 || ! released) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("File system check: fail")));
+	exit (183);
+    }
+    file.unlink();
+} // test_filesystem
+
+void test_fingerprint(const OksSystem::File &file) {
+  TLOG_DEBUG( 1) << "Testing change fingerprints"; 
+    std::ostream *stream = file.output();
+    *stream << "first" << std::endl;
+    delete stream;
+    const OksSystem::FileFingerprint before = file.fingerprint();
+    int loads = 0;
+    const std::function<std::shared_ptr<const std::string>(const OksSystem::File &)> loader = [&loads](const OksSystem::File &f) { loads++; return std::make_shared<const std::string>(f.content().view()); };
+    OksSystem::FingerprintCache &cache = OksSystem::FingerprintCache::instance();
+    const std::string first = *cache.memoize<std::string>(file,"content",loader);
+    // the file was just written, the fingerprint is racy and the content is loaded again
+    const std::string again = *cache.memoize<std::string>(file,"content",loader);
+    const bool unchanged = file.unchanged_since(before) && before.racy(OksSystem::FileFingerprint::clock_ns());
+    stream = file.output();
+    *stream << "fjrst" << std::endl;
+    delete stream;
+    const std::string rewritten = *cache.memoize<std::string>(file,"content",loader);
+    stream = file.output(true);
+    *stream << "second" << std::endl;
+    delete stream;
+    const std::string second = *cache.memoize<std::string>(file,"content",loader);
+    const bool settled = ! before.racy(before.change_ns()+OksSystem::FileFingerprint::RACY_NS);
+    const bool ok = unchanged && settled && ! file.unchanged_since(before) && first=="first\n" && again=="first\n" 
+	&& rewritten=="fjrst\n" && second=="fjrst\nsecond\n" && loads==4 && cache.changed(file);
+    cache.forget(file);
+    file.unlink();
+    if (! ok) {
+	ers::warning(OksSystem::Exception(ERS_HERE, std::string("Fingerprint check: fail")));
+	exit (183);
+    }
+} // test_fingerprint
+
 void test_host() {
   TLOG_DEBUG( 1) << "Checking host information" ; 
     const OksSystem::LocalHost *host = OksSystem::LocalHost::instance();
@@ -126,12 +624,30 @@ int main(int , char** argv) {
 	test_okssystem(file,"Hello world"); 
 	test_map_file(file); 
 	test_write_chmod(file); 
+	test_status(file); 
+	test_lexical(); 
+	test_file_type(); 
+	test_stat_many(); 
+	test_file_id(OksSystem::File("/tmp")); 
+	test_symlink(OksSystem::File("/tmp")); 
+	test_filesystem(OksSystem::File("/tmp/okssystem_reserved", OksSystem::File::LEXICAL)); 
+	test_fingerprint(OksSystem::File("/tmp/okssystem_fingerprint", OksSystem::File::LEXICAL)); 
+	test_copy(OksSystem::File("/tmp")); 
+	test_content(OksSystem::File("/tmp/okssystem_content", OksSystem::File::LEXICAL)); 
+	test_atomic_write(OksSystem::File("/tmp/okssystem_atomic", OksSystem::File::LEXICAL)); 
+	test_descriptor_stream(OksSystem::File("/tmp/okssystem_stream", OksSystem::File::LEXICAL)); 
+	test_temporary(OksSystem::File("/tmp")); 
+	test_watcher(OksSystem::File("/tmp/okssystem_watch", OksSystem::File::LEXICAL)); 
+	test_line_reader(OksSystem::File("/tmp/okssystem_lines", OksSystem::File::LEXICAL)); 
+	test_content_hash(OksSystem::File("/tmp/okssystem_hash", OksSystem::File::LEXICAL)); 
 	test_exec(file,0); 
 	test_delete_file(file); 
 	OksSystem::File dir_a("/tmp/really/stupid/path/");
 	test_mkdir(dir_a); 
+	test_entries(OksSystem::File("/tmp/really/stupid"),"path"); 
 	OksSystem::File dir_b("/tmp/really/");
 	test_rmdir(dir_b);
+	test_remove_tree(OksSystem::File("/tmp/okssystem_tree")); 
 	OksSystem::Path path("/bin::/usr/bin:/usr/local/bin:/sbin/");
 	test_path(path,"ping"); 
 	test_host();